@@ -19,11 +19,15 @@
 
 
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 #include <sys/stat.h>
+#include <sys/inotify.h>
 
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
+#include <QFileInfo>
 #include <QDebug>
 #include <QStandardPaths>
 
@@ -38,13 +42,32 @@ enum class Result {
     Unknown,
 };
 
+// The parsed content of a restricted_interfaces.conf, kept until inotify
+// tells the file changed
+struct PolicyFile {
+    QString path;
+    bool loaded;
+    bool usable;
+    QJsonObject config;
+};
+
 class Helper {
 public:
     Helper()
         : display(wl_display_connect(nullptr))
         , registry(wl_display_get_registry(display))
         , helper(nullptr)
+        , inotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
     {
+        QString path = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
+        files[0] = { path + QLatin1String("/orbital/restricted_interfaces.conf"), false, false, QJsonObject() };
+        files[1] = { QStringLiteral("/etc/orbital/restricted_interfaces.conf"), false, false, QJsonObject() };
+        if (inotifyFd < 0) {
+            qWarning("Cannot watch the configuration for changes: %s", strerror(errno));
+        } else {
+            addWatches();
+        }
+
         static const wl_registry_listener registryListener = {
             wrapInterface(&Helper::global),
             wrapInterface(&Helper::globalRemove)
@@ -55,6 +78,9 @@ public:
     }
     ~Helper()
     {
+        if (inotifyFd >= 0) {
+            close(inotifyFd);
+        }
         orbital_authorizer_helper_destroy(helper);
         wl_registry_destroy(registry);
         wl_display_disconnect(display);
@@ -64,7 +90,7 @@ public:
     {
 #define registry_bind(type, v) static_cast<type *>(wl_registry_bind(registry, id, &type ## _interface, qMin(version, v)))
         if (strcmp(interface, "orbital_authorizer_helper") == 0) {
-            helper = registry_bind(orbital_authorizer_helper, 1u);
+            helper = registry_bind(orbital_authorizer_helper, 2u);
             static const orbital_authorizer_helper_listener listener = {
                 wrapInterface(&Helper::authorizationRequested)
             };
@@ -97,57 +123,75 @@ public:
             orbital_authorizer_helper_result_result(result, ORBITAL_AUTHORIZER_HELPER_RESULT_RESULT_VALUE_DENY);
         }
 
+        // Without inotify the files must be read again every time, and the
+        // compositor cannot keep the decision either
+        if (inotifyFd < 0) {
+            policyChanged();
+        }
     }
 
     bool authorizeProcess(const char *global, const char *executable)
     {
-        QString path = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
-        Result res = readFile(path + QLatin1String("/orbital/restricted_interfaces.conf"), global, executable);
-        if (res == Result::Unknown) {
-            res = readFile(QStringLiteral("/etc/orbital/restricted_interfaces.conf"), global, executable);
+        Result res = Result::Unknown;
+        for (PolicyFile &file: files) {
+            res = lookup(file, global, executable);
+            if (res != Result::Unknown) {
+                break;
+            }
         }
         return res == Result::Allow;
     }
 
-    Result readFile(const QString &path, const char *global, const char *executable)
+    void load(PolicyFile &file)
     {
+        const QString &path = file.path;
+        file.loaded = true;
+        file.usable = false;
+        file.config = QJsonObject();
+
         struct stat st;
         if (stat(qPrintable(path), &st) < 0) {
             qWarning("Cannot stat %s\n", qPrintable(path));
-            return Result::Unknown;
+            return;
         }
 
         if (st.st_uid != 0) {
             qWarning("Cannot use %s. The file must be owned by root!", qPrintable(path));
-            return Result::Unknown;
+            return;
         }
 
         if (st.st_mode & S_IWOTH || st.st_mode & S_IWGRP) {
             qWarning("Cannot use %s. The file must not be writable by normal users!", qPrintable(path));
-            return Result::Unknown;
+            return;
         }
 
-        QFile file(path);
-        if (!file.open(QIODevice::ReadOnly)) {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly)) {
             qWarning("Cannot open %s", qPrintable(path));
-            return Result::Unknown;
+            return;
         }
 
         QJsonParseError error;
-        QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+        QJsonDocument document = QJsonDocument::fromJson(f.readAll(), &error);
         if (error.error != QJsonParseError::NoError) {
             qWarning("Error parsing %s at offset %d: %s", qPrintable(path), error.offset, qPrintable(error.errorString()));
-            return Result::Unknown;
+            return;
         }
 
-        QJsonObject config = document.object();
-        file.close();
+        file.config = document.object();
+        file.usable = true;
+    }
 
-        if (!config.contains(QLatin1String(global))) {
+    Result lookup(PolicyFile &file, const char *global, const char *executable)
+    {
+        if (!file.loaded) {
+            load(file);
+        }
+        if (!file.usable || !file.config.contains(QLatin1String(global))) {
             return Result::Unknown;
         }
 
-        config = config.value(QLatin1String(global)).toObject();
+        QJsonObject config = file.config.value(QLatin1String(global)).toObject();
         QJsonValue value = config.value(QString::fromUtf8(executable));
         if (value != QJsonValue::Undefined) {
             QString v = value.toString();
@@ -160,9 +204,61 @@ public:
         return Result::Unknown;
     }
 
+    // Watch the directories rather than the files, since editors usually replace
+    // the files instead of writing them in place. A directory that does not exist
+    // yet is waited for in its parent.
+    void addWatches()
+    {
+        const uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+                                IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+        for (const PolicyFile &file: files) {
+            QString dir = QFileInfo(file.path).absolutePath();
+            if (inotify_add_watch(inotifyFd, qPrintable(dir), events) < 0) {
+                dir = QFileInfo(dir).absolutePath();
+                if (inotify_add_watch(inotifyFd, qPrintable(dir), IN_CREATE | IN_MOVED_TO) < 0) {
+                    qWarning("Cannot watch '%s' for changes: %s", qPrintable(dir), strerror(errno));
+                }
+            }
+        }
+    }
+
+    void filesChanged()
+    {
+        alignas(inotify_event) char buf[4096];
+        bool changed = false;
+        ssize_t len;
+        while ((len = read(inotifyFd, buf, sizeof(buf))) > 0) {
+            for (char *p = buf; p < buf + len;) {
+                auto *event = reinterpret_cast<inotify_event *>(p);
+                if (!event->len || strcmp(event->name, "restricted_interfaces.conf") == 0 || strcmp(event->name, "orbital") == 0) {
+                    changed = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (changed) {
+            qDebug("Configuration changed, reloading it");
+            addWatches();
+            policyChanged();
+        }
+    }
+
+    void policyChanged()
+    {
+        for (PolicyFile &file: files) {
+            file.loaded = false;
+        }
+        if (orbital_authorizer_helper_get_version(helper) >= ORBITAL_AUTHORIZER_HELPER_POLICY_CHANGED_SINCE_VERSION) {
+            orbital_authorizer_helper_policy_changed(helper);
+        }
+    }
+
     wl_display *display;
     wl_registry *registry;
     orbital_authorizer_helper *helper;
+    int inotifyFd;
+    PolicyFile files[2];
 };
 
 int main(int argc, char **argv)
@@ -173,9 +269,31 @@ int main(int argc, char **argv)
         exit(1);
     }
 
-    int ret = 0;
-    while (ret != -1)
-        ret = wl_display_dispatch(helper.display);
+    pollfd fds[2] = {
+        { wl_display_get_fd(helper.display), POLLIN, 0 },
+        { helper.inotifyFd, POLLIN, 0 },
+    };
+    while (true) {
+        wl_display_dispatch_pending(helper.display);
+        if (wl_display_flush(helper.display) < 0 && errno != EAGAIN) {
+            break;
+        }
+        if (poll(fds, helper.inotifyFd < 0 ? 1 : 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            helper.filesChanged();
+        }
+        if (fds[0].revents & (POLLERR | POLLHUP)) {
+            break;
+        }
+        if (fds[0].revents & POLLIN && wl_display_dispatch(helper.display) == -1) {
+            break;
+        }
+    }
 
     return 0;
 }
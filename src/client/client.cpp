@@ -94,6 +94,7 @@ Binding::~Binding()
 Client::Client()
       : QObject()
       , m_notifications(nullptr)
+      , m_shm(nullptr)
       , m_ui(nullptr)
       , d_ptr(new ClientPrivate(this))
 {
@@ -478,6 +479,8 @@ void Client::handleGlobal(wl_registry *registry, uint32_t id, const char *interf
         m_notifications = static_cast<notifications_manager *>(wl_registry_bind(registry, id, &notifications_manager_interface, 1));
     } else if (strcmp(interface, "wl_subcompositor") == 0) {
         m_subcompositor = static_cast<wl_subcompositor *>(wl_registry_bind(registry, id, &wl_subcompositor_interface, 1));
+    } else if (strcmp(interface, "wl_shm") == 0) {
+        m_shm = static_cast<wl_shm *>(wl_registry_bind(registry, id, &wl_shm_interface, 1));
     } else if (strcmp(interface, "orbital_clipboard_manager") == 0) {
         wl_registry_bind(registry, id, &orbital_clipboard_manager_interface, 1);
     }
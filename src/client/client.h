@@ -40,6 +40,7 @@ struct wl_output;
 struct wl_subcompositor;
 struct wl_subsurface;
 struct wl_seat;
+struct wl_shm;
 
 struct desktop_shell;
 struct desktop_shell_listener;
@@ -101,6 +102,7 @@ public:
     QQmlEngine *qmlEngine() const { return m_engine; }
 
     static Client *client() { return s_client; }
+    wl_shm *shm() const { return m_shm; }
     static QLocale locale();
 
     void setBackground(QQuickWindow *window, QScreen *screen);
@@ -170,6 +172,7 @@ private:
     desktop_shell *m_shell;
     notifications_manager *m_notifications;
     wl_subcompositor *m_subcompositor;
+    wl_shm *m_shm;
     QQmlEngine *m_engine;
     QWindow *m_grabWindow;
     QList<Binding *> m_bindings;
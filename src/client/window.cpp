@@ -17,8 +17,13 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <QDebug>
 
+#include <wayland-client.h>
+
 #include "window.h"
 #include "wayland-desktop-shell-client-protocol.h"
 #include "utils.h"
@@ -66,15 +71,29 @@ void Window::handleState(desktop_shell_window *window, int32_t state)
 
 void Window::handleRemoved(desktop_shell_window *window)
 {
+    destroyThumbnailBuffer();
     emit destroyed(this);
     deleteLater();
 }
 
+void Window::handleThumbnail(desktop_shell_window *window, int32_t width, int32_t height)
+{
+    if (!m_thumbnailBuffer) {
+        return;
+    }
+
+    m_thumbnail = QImage(m_thumbnailData, width, height, m_thumbnailSize.width() * 4, QImage::Format_ARGB32_Premultiplied).copy();
+    emit thumbnailChanged();
+    // give the buffer back to get the next update
+    desktop_shell_window_set_thumbnail_buffer(m_window, m_thumbnailBuffer);
+}
+
 const desktop_shell_window_listener Window::m_window_listener = {
     wrapInterface(&Window::handleTitle),
     wrapInterface(&Window::handleIcon),
     wrapInterface(&Window::handleState),
-    wrapInterface(&Window::handleRemoved)
+    wrapInterface(&Window::handleRemoved),
+    wrapInterface(&Window::handleThumbnail)
 };
 
 Window::Window(desktop_shell_window *window, pid_t pid, QObject *p)
@@ -82,12 +101,15 @@ Window::Window(desktop_shell_window *window, pid_t pid, QObject *p)
       , m_window(window)
       , m_pid(pid)
       , m_state(Window::Inactive)
+      , m_thumbnailBuffer(nullptr)
+      , m_thumbnailData(nullptr)
 {
     desktop_shell_window_add_listener(window, &m_window_listener, this);
 }
 
 Window::~Window()
 {
+    destroyThumbnailBuffer();
     desktop_shell_window_destroy(m_window);
 }
 
@@ -129,3 +151,64 @@ void Window::endPreview(UiScreen *screen)
     wl_output *o = Client::client()->nativeOutput(screen->screen());
     desktop_shell_window_end_preview(m_window, o);
 }
+
+void Window::requestThumbnail(const QSize &size)
+{
+    if (size == m_thumbnailSize && m_thumbnailBuffer) {
+        return;
+    }
+    releaseThumbnail();
+    wl_shm *shm = Client::client()->shm();
+    if (!shm || size.isEmpty() || desktop_shell_window_get_version(m_window) < DESKTOP_SHELL_WINDOW_SET_THUMBNAIL_BUFFER_SINCE_VERSION) {
+        return;
+    }
+
+    const int stride = size.width() * 4;
+    const int bytes = stride * size.height();
+    int fd = memfd_create("orbital-thumbnail", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, bytes) < 0) {
+        qWarning("Cannot create a thumbnail buffer: %m");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        qWarning("Cannot map a thumbnail buffer: %m");
+        close(fd);
+        return;
+    }
+
+    wl_shm_pool *pool = wl_shm_create_pool(shm, fd, bytes);
+    m_thumbnailBuffer = wl_shm_pool_create_buffer(pool, 0, size.width(), size.height(), stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    m_thumbnailData = static_cast<uchar *>(data);
+    m_thumbnailSize = size;
+    desktop_shell_window_set_thumbnail_buffer(m_window, m_thumbnailBuffer);
+}
+
+void Window::releaseThumbnail()
+{
+    if (!m_thumbnailBuffer) {
+        return;
+    }
+
+    desktop_shell_window_set_thumbnail_buffer(m_window, nullptr);
+    destroyThumbnailBuffer();
+}
+
+void Window::destroyThumbnailBuffer()
+{
+    if (!m_thumbnailBuffer) {
+        return;
+    }
+
+    wl_buffer_destroy(m_thumbnailBuffer);
+    munmap(m_thumbnailData, m_thumbnailSize.width() * 4 * m_thumbnailSize.height());
+    m_thumbnailBuffer = nullptr;
+    m_thumbnailData = nullptr;
+    m_thumbnailSize = QSize();
+}
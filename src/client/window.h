@@ -21,9 +21,11 @@
 #define WINDOW_H
 
 #include <QObject>
+#include <QImage>
 
 struct desktop_shell_window;
 struct desktop_shell_window_listener;
+struct wl_buffer;
 
 class UiScreen;
 
@@ -34,6 +36,7 @@ class Window : public QObject
     Q_PROPERTY(QString title READ title NOTIFY titleChanged)
     Q_PROPERTY(QString icon READ icon NOTIFY iconChanged);
     Q_PROPERTY(States state READ state NOTIFY stateChanged)
+    Q_PROPERTY(QImage thumbnail READ thumbnail NOTIFY thumbnailChanged)
 public:
     enum State {
         Inactive = 0,
@@ -60,6 +63,11 @@ public:
     Q_INVOKABLE bool isActive() const;
     Q_INVOKABLE bool isMinimized() const;
 
+    inline QImage thumbnail() const { return m_thumbnail; }
+    // Keeps the thumbnail updated, scaled to fit in size, until releaseThumbnail() is called
+    Q_INVOKABLE void requestThumbnail(const QSize &size);
+    Q_INVOKABLE void releaseThumbnail();
+
 public slots:
     void close();
     void preview(UiScreen *screen);
@@ -70,18 +78,25 @@ signals:
     void titleChanged();
     void iconChanged();
     void stateChanged();
+    void thumbnailChanged();
 
 private:
     void handleTitle(desktop_shell_window *window, const char *title);
     void handleIcon(desktop_shell_window *window, const char *name);
     void handleState(desktop_shell_window *window, int32_t state);
     void handleRemoved(desktop_shell_window *window);
+    void handleThumbnail(desktop_shell_window *window, int32_t width, int32_t height);
+    void destroyThumbnailBuffer();
 
     desktop_shell_window *m_window;
     pid_t m_pid;
     QString m_title;
     QString m_icon;
     States m_state;
+    QImage m_thumbnail;
+    wl_buffer *m_thumbnailBuffer;
+    uchar *m_thumbnailData;
+    QSize m_thumbnailSize;
 
     static const desktop_shell_window_listener m_window_listener;
 };
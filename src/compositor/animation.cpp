@@ -18,21 +18,16 @@
  */
 
 #include "animation.h"
-#include "animationcurve.h"
 #include "output.h"
+#include "compositor.h"
 
 namespace Orbital {
 
 BaseAnimation::BaseAnimation()
          : m_speed(-1.)
-         , m_curve(nullptr)
+         , m_timeline(nullptr)
+         , m_slot(0)
 {
-    m_animation.parent = this;
-    wl_list_init(&m_animation.ani.link);
-    m_animation.ani.frame = [](weston_animation *base, weston_output *output, uint32_t msecs) {
-        AnimWrapper *animation = wl_container_of(base, (AnimWrapper *)nullptr, ani);
-        animation->parent->tick(output, msecs);
-    };
 }
 
 BaseAnimation::~BaseAnimation()
@@ -55,12 +50,7 @@ void BaseAnimation::run(Output *output, uint32_t duration)
         return;
     }
 
-    m_duration = duration;
-    m_animation.ani.frame_counter = 0;
-
-    wl_list_insert(&output->m_output->animation_list, &m_animation.ani.link);
-    weston_output_schedule_repaint(output->m_output);
-
+    output->timeline()->add(this, duration);
     updateAnim(0.);
 }
 
@@ -77,39 +67,142 @@ void BaseAnimation::run(Output *output)
 
 void BaseAnimation::stop()
 {
-    if (isRunning()) {
-        wl_list_remove(&m_animation.ani.link);
-        wl_list_init(&m_animation.ani.link);
+    if (m_timeline) {
+        m_timeline->remove(this);
     }
 }
 
 bool BaseAnimation::isRunning() const
 {
-    return !wl_list_empty(&m_animation.ani.link);
+    return m_timeline;
+}
+
+
+AnimationTimeline::AnimationTimeline(Output *output)
+                 : m_output(output)
+                 , m_ticking(false)
+{
+    m_animation.parent = this;
+    wl_list_init(&m_animation.ani.link);
+    m_animation.ani.frame = [](weston_animation *base, weston_output *output, uint32_t msecs) {
+        AnimWrapper *animation = wl_container_of(base, (AnimWrapper *)nullptr, ani);
+        animation->parent->tick(msecs);
+    };
 }
 
-void BaseAnimation::tick(weston_output *output, uint32_t msecs)
+AnimationTimeline::~AnimationTimeline()
 {
-    if (m_animation.ani.frame_counter <= 1) {
-        m_timestamp = msecs;
+    for (BaseAnimation *a: m_animations) {
+        if (a) {
+            a->m_timeline = nullptr;
+        }
     }
+    wl_list_remove(&m_animation.ani.link);
+}
 
-    uint32_t time = msecs - m_timestamp;
-    if (time > m_duration) {
-        updateAnim(1.);
-        stop();
-        weston_compositor_schedule_repaint(output->compositor);
-        done();
-        return;
+void AnimationTimeline::add(BaseAnimation *animation, uint32_t duration)
+{
+    animation->m_timeline = this;
+    animation->m_slot = m_animations.size();
+    m_animations.push_back(animation);
+    m_start.push_back(0);
+    m_duration.push_back(duration);
+    m_frames.push_back(0);
+    m_curves.push_back(animation->m_curve);
+
+    if (wl_list_empty(&m_animation.ani.link)) {
+        m_animation.ani.frame_counter = 0;
+        wl_list_insert(&m_output->output()->animation_list, &m_animation.ani.link);
     }
+    weston_output_schedule_repaint(m_output->output());
+}
 
-    double f = (double)time / (double)m_duration;
-    if (m_curve) {
-        f = m_curve->value(f);
+void AnimationTimeline::remove(BaseAnimation *animation)
+{
+    m_animations[animation->m_slot] = nullptr;
+    animation->m_timeline = nullptr;
+    // While ticking the arrays are compacted at the end of the pass
+    if (!m_ticking) {
+        compact();
     }
-    updateAnim(f);
+}
 
-    weston_compositor_schedule_repaint(output->compositor);
+void AnimationTimeline::tick(uint32_t msecs)
+{
+    m_ticking = true;
+
+    // Animations added by the callbacks below will start on the next frame
+    const size_t count = m_animations.size();
+    m_values.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        // The timestamp of the first frame may be stale, start counting from the second one
+        if (m_frames[i] < 2) {
+            m_start[i] = msecs;
+            ++m_frames[i];
+        }
+        uint32_t time = msecs - m_start[i];
+        m_values[i] = time >= m_duration[i] ? 1.f : m_curves[i].value((float)time / (float)m_duration[i]);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        BaseAnimation *a = m_animations[i];
+        if (!a) {
+            continue;
+        }
+
+        bool finished = msecs - m_start[i] >= m_duration[i];
+        a->updateAnim(m_values[i]);
+        if (finished && m_animations[i] == a) {
+            remove(a);
+            a->done();
+        }
+    }
+
+    m_ticking = false;
+    compact();
+
+    // The views changed by the animations scheduled the repaint of the outputs
+    // they are on, this only keeps the timeline going while it has animations
+    if (!m_animations.empty()) {
+        weston_output_schedule_repaint(m_output->output());
+    }
+
+    // The other outputs are only repainted if the animations touched views on them
+    Compositor *c = Compositor::fromCompositor(m_output->output()->compositor);
+    for (Output *o: c->outputs()) {
+        if (o != m_output && !o->output()->repaint_needed) {
+            o->frameStats().repaintAvoided();
+        }
+    }
+}
+
+void AnimationTimeline::compact()
+{
+    size_t j = 0;
+    for (size_t i = 0; i < m_animations.size(); ++i) {
+        if (!m_animations[i]) {
+            continue;
+        }
+        if (i != j) {
+            m_animations[j] = m_animations[i];
+            m_start[j] = m_start[i];
+            m_duration[j] = m_duration[i];
+            m_frames[j] = m_frames[i];
+            m_curves[j] = m_curves[i];
+            m_animations[j]->m_slot = j;
+        }
+        ++j;
+    }
+    m_animations.resize(j);
+    m_start.resize(j);
+    m_duration.resize(j);
+    m_frames.resize(j);
+    m_curves.resize(j);
+
+    if (j == 0) {
+        wl_list_remove(&m_animation.ani.link);
+        wl_list_init(&m_animation.ani.link);
+    }
 }
 
 }
@@ -20,15 +20,17 @@
 #ifndef ORBITAL_ANIMATION_H
 #define ORBITAL_ANIMATION_H
 
-#include <memory>
+#include <vector>
 
 #include <compositor.h>
 
 #include "utils.h"
+#include "animationcurve.h"
 
 namespace Orbital {
 
 class Output;
+class AnimationTimeline;
 
 class BaseAnimation
 {
@@ -42,10 +44,8 @@ public:
     void run(Output *output);
     void stop();
     bool isRunning() const;
-    template<class T>
-    void setCurve(const T &curve) {
-        m_curve = std::make_unique<Curve<T>>(curve);
-    }
+    // The curve is used starting from the next run()
+    void setCurve(const Curve &curve) { m_curve = curve; }
 
     Signal<> done;
 
@@ -53,30 +53,48 @@ protected:
     virtual void updateAnim(double value) = 0;
 
 private:
-    void tick(weston_output *output, uint32_t msecs);
+    double m_speed;
+    Curve m_curve;
+    AnimationTimeline *m_timeline;
+    size_t m_slot;
 
-    struct AnimationCurve
-    {
-        virtual ~AnimationCurve() {}
-        virtual double value(double f) = 0;
-    };
-    template<class T>
-    struct Curve : public AnimationCurve
-    {
-        Curve(const T &c) : curve(c) {}
-        double value(double f) override { return curve.value(f); }
-        T curve;
-    };
+    friend AnimationTimeline;
+};
+
+/**
+ * Drives all the animations running on an output with a single
+ * weston_animation. On every frame the curves of all the animations
+ * are evaluated in one pass, then the animations are updated and
+ * only one repaint is scheduled.
+ */
+class AnimationTimeline
+{
+public:
+    explicit AnimationTimeline(Output *output);
+    ~AnimationTimeline();
+
+    void add(BaseAnimation *animation, uint32_t duration);
+    void remove(BaseAnimation *animation);
+
+private:
+    void tick(uint32_t msecs);
+    void compact();
 
     struct AnimWrapper {
         weston_animation ani;
-        BaseAnimation *parent;
+        AnimationTimeline *parent;
     };
+    Output *m_output;
     AnimWrapper m_animation;
-    uint32_t m_duration;
-    double m_speed;
-    uint32_t m_timestamp;
-    std::unique_ptr<AnimationCurve> m_curve;
+    bool m_ticking;
+
+    // Indexed by BaseAnimation::m_slot
+    std::vector<BaseAnimation *> m_animations;
+    std::vector<uint32_t> m_start;
+    std::vector<uint32_t> m_duration;
+    std::vector<uint8_t> m_frames;
+    std::vector<Curve> m_curves;
+    std::vector<float> m_values;
 };
 
 template<class T>
@@ -21,6 +21,7 @@
 #define ORBITAL_ANIMATIONCURVE_H
 
 #include <stdio.h>
+#include <math.h>
 
 namespace Orbital {
 
@@ -64,7 +65,7 @@ OF THE POSSIBILITY OF SUCH DAMAGE.
 
 class InOutQuadCurve {
 public:
-    float value(float f) {
+    float value(float f) const {
         f *= 2.f;
         if (f < 1.f) {
             return f * f/ 2.f;
@@ -87,7 +88,7 @@ protected:
 
 class OutBackCurve : public BackCurve {
 public:
-    float value(float t) {
+    float value(float t) const {
         float s = m_overshoot;
         t -= 1.f;
         return t*t*((s+1)*t+ s) + 1;
@@ -97,7 +98,7 @@ public:
 
 class InOutBackCurve : public BackCurve {
 public:
-    float value(float t) {
+    float value(float t) const {
         float s = m_overshoot;
         t *= 2.0;
         if (t < 1) {
@@ -113,7 +114,7 @@ public:
 
 class OutBounceCurve {
 public:
-    float value(float t) {
+    float value(float t) const {
         float c = 1.f;
         float a = 0.5f;
         if (t < (4/11.0)) {
@@ -144,7 +145,7 @@ protected:
 
 class OutElasticCurve : public ElasticCurve {
 public:
-    float value(float t) {
+    float value(float t) const {
         if (t == 0.f) return 0.f;
         if (t == 1.f) return 1.f;
 
@@ -168,7 +169,7 @@ public:
     PulseCurve() { m_pulseNormalize = 1.f; m_pulseNormalize = 1.f / pulse(1); }
 
     // viscous fluid with a pulse for part and decay for the rest
-    float value(float x) {
+    float value(float x) const {
         if (x >= 1) return 1;
         if (x <= 0) return 0;
 
@@ -177,7 +178,7 @@ public:
 
 private:
     // viscous fluid with a pulse for part and decay for the rest
-    float pulse(float x)
+    float pulse(float x) const
     {
         const float pulseScale = 8; // ratio of "tail" to "acceleration"
         float val;
@@ -202,6 +203,54 @@ private:
     float m_pulseNormalize;
 };
 
+/**
+ * A value type holding any of the curves above, so that evaluating it
+ * does not need a virtual call nor an allocation.
+ */
+class Curve {
+public:
+    Curve() : m_type(Type::Linear) {}
+    Curve(const InOutQuadCurve &c) : m_type(Type::InOutQuad), m_inOutQuad(c) {}
+    Curve(const OutBackCurve &c) : m_type(Type::OutBack), m_outBack(c) {}
+    Curve(const InOutBackCurve &c) : m_type(Type::InOutBack), m_inOutBack(c) {}
+    Curve(const OutBounceCurve &c) : m_type(Type::OutBounce), m_outBounce(c) {}
+    Curve(const OutElasticCurve &c) : m_type(Type::OutElastic), m_outElastic(c) {}
+    Curve(const PulseCurve &c) : m_type(Type::Pulse), m_pulse(c) {}
+
+    float value(float f) const {
+        switch (m_type) {
+            case Type::Linear: return f;
+            case Type::InOutQuad: return m_inOutQuad.value(f);
+            case Type::OutBack: return m_outBack.value(f);
+            case Type::InOutBack: return m_inOutBack.value(f);
+            case Type::OutBounce: return m_outBounce.value(f);
+            case Type::OutElastic: return m_outElastic.value(f);
+            case Type::Pulse: return m_pulse.value(f);
+        }
+        return f;
+    }
+
+private:
+    enum class Type {
+        Linear,
+        InOutQuad,
+        OutBack,
+        InOutBack,
+        OutBounce,
+        OutElastic,
+        Pulse
+    };
+    Type m_type;
+    union {
+        InOutQuadCurve m_inOutQuad;
+        OutBackCurve m_outBack;
+        InOutBackCurve m_inOutBack;
+        OutBounceCurve m_outBounce;
+        OutElasticCurve m_outElastic;
+        PulseCurve m_pulse;
+    };
+};
+
 }
 
 #endif
@@ -19,6 +19,9 @@
 
 #include <functional>
 
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include <QDebug>
 
 #include "authorizer.h"
@@ -34,7 +37,7 @@ class Helper: public Global
 {
 public:
     Helper(Compositor *c, Authorizer *auth)
-        : Global(c, &orbital_authorizer_helper_interface, 1)
+        : Global(c, &orbital_authorizer_helper_interface, 2)
         , m_auth(auth)
         , m_client(c->launchProcess(LIBEXEC_PATH "/orbital-authorizer-helper"))
         , m_resource(nullptr)
@@ -43,6 +46,9 @@ public:
     }
     ~Helper()
     {
+        if (m_resource) {
+            wl_resource_set_destructor(m_resource, nullptr);
+        }
         delete m_client;
     }
 
@@ -56,12 +62,28 @@ public:
         }
         m_resource = res;
 
+        static const struct orbital_authorizer_helper_interface impl = {
+            wrapInterface(policyChanged)
+        };
+        wl_resource_set_implementation(res, &impl, this, [](wl_resource *res) {
+            Helper *helper = static_cast<Helper *>(wl_resource_get_user_data(res));
+            if (helper->m_resource == res) {
+                helper->m_resource = nullptr;
+            }
+        });
+
         for (auto &req: m_pendingRequests) {
             sendAuthRequest(req.interface.c_str(), req.pid, req.cb);
         }
         m_pendingRequests.clear();
     }
 
+    void policyChanged()
+    {
+        qDebug("The restricted interfaces configuration changed.");
+        m_auth->clearDecisions();
+    }
+
     void sendAuthRequest(const char *interface, pid_t pid, const std::function<void (int32_t)> &cb)
     {
         class Request {
@@ -130,10 +152,41 @@ public:
 };
 
 
+// The helper decides by the executable path, but the file behind a path can be
+// replaced, so the decisions are cached by the file identity too.
+static std::string decisionKey(const char *interface, pid_t pid)
+{
+    char path[256], buf[256];
+    int ret = snprintf(path, sizeof(path), "/proc/%d/exe", pid);
+    if ((size_t)ret >= sizeof(path)) {
+        return std::string();
+    }
+
+    ret = readlink(path, buf, sizeof(buf));
+    if (ret == -1 || (size_t)ret == sizeof(buf)) {
+        return std::string();
+    }
+
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        return std::string();
+    }
+
+    std::string key = interface;
+    key += '\0';
+    key.append(buf, ret);
+    key += '\0';
+    key += std::to_string(st.st_dev) + ':' + std::to_string(st.st_ino) + ':' +
+           std::to_string(st.st_mtim.tv_sec) + '.' + std::to_string(st.st_mtim.tv_nsec);
+    return key;
+}
+
+
 Authorizer::Authorizer(Compositor *compositor)
           : QObject(compositor)
           , Global(compositor, &orbital_authorizer_interface, 1)
           , m_helper(new Helper(compositor, this))
+          , m_decisionsSerial(0)
 {
 }
 
@@ -195,6 +248,12 @@ bool Authorizer::isClientTrusted(StringView interface, wl_client *c) const
     return false;
 }
 
+void Authorizer::clearDecisions()
+{
+    m_decisions.clear();
+    ++m_decisionsSerial;
+}
+
 void Authorizer::bind(wl_client *client, uint32_t version, uint32_t id)
 {
     static const struct orbital_authorizer_interface implementation = {
@@ -226,8 +285,28 @@ void Authorizer::authorize(wl_client *client, wl_resource *res, uint32_t id, con
 
     qDebug("Authorization for global '%s' requested by process %d.", global, pid);
 
+    std::string key = decisionKey(global, pid);
+    if (!key.empty()) {
+        auto it = m_decisions.find(key);
+        if (it != m_decisions.end()) {
+            qDebug("Using the cached decision.");
+            if (it->second) {
+                grant(resource);
+                addTrustedClient(global, client);
+            } else {
+                deny(resource);
+            }
+            return;
+        }
+    }
+
     std::string iface = global; //take a copy or 'global' may become invalid when the callback runs
-    m_helper->authRequested(global, pid, [this, iface, client, resource](int32_t result) {
+    uint32_t serial = m_decisionsSerial;
+    m_helper->authRequested(global, pid, [this, iface, key, serial, client, resource](int32_t result) {
+        // Don't keep an answer given with a configuration that changed meanwhile
+        if (!key.empty() && serial == m_decisionsSerial) {
+            m_decisions[key] = result == 1;
+        }
         if (result == 1) {
             qDebug("Authorization granted.");
             grant(resource);
@@ -48,6 +48,7 @@ public:
     void removeRestrictedInterface(StringView interface);
 
     bool isClientTrusted(StringView interface, wl_client *c) const;
+    void clearDecisions();
 
 protected:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
@@ -62,6 +63,9 @@ private:
     std::vector<std::string> m_restrictedIfaces;
     std::unordered_map<std::string, std::list<TrustedClient>> m_trustedClients;
     Helper *m_helper;
+    // The helper's answers, by interface and executable identity
+    std::unordered_map<std::string, bool> m_decisions;
+    uint32_t m_decisionsSerial;
 };
 
 }
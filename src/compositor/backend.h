@@ -32,13 +32,15 @@ struct weston_compositor;
 
 namespace Orbital {
 
+class Config;
+
 class Backend : public QObject
 {
     Q_OBJECT
 public:
     Backend();
 
-    virtual bool init(weston_compositor *c) = 0;
+    virtual bool init(weston_compositor *c, const Config &config) = 0;
 };
 
 class BackendFactory
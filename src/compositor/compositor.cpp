@@ -21,15 +21,12 @@
 #include <signal.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
-#include <sys/resource.h>
+#include <sys/timerfd.h>
 #include <linux/input.h>
 
 #include <QDebug>
-#include <QProcess>
+#include <QCoreApplication>
 #include <QObjectCleanupHandler>
-#include <QJsonDocument>
-#include <QStandardPaths>
-#include <QFile>
 
 #include <compositor.h>
 
@@ -49,6 +46,12 @@
 #include "fmt/format.h"
 #include "fmt/ostream.h"
 #include "debug.h"
+#include "viewindex.h"
+#include "timerwheel.h"
+#include "loopmonitor.h"
+#include "eventdispatcher.h"
+#include "framethrottle.h"
+#include "process.h"
 
 namespace Orbital {
 
@@ -61,13 +64,104 @@ volatile sig_atomic_t alarmFired = 0;
 
 static wl_event_loop *s_event_loop;
 
+// All the Timers share a single timerfd, driven by a timer wheel
+struct SingleShot {
+    TimerWheel::Node node;
+    std::function<void ()> func;
+};
+
+struct Timers {
+    TimerWheel wheel;
+    int fd;
+    wl_event_source *source;
+    uint64_t armed;
+    std::vector<SingleShot *> pool;
+};
+static Timers *s_timers;
+
+static uint64_t monotonicMsecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void updateTimerFd()
+{
+    uint64_t next = s_timers->wheel.nextExpiry();
+    if (next == s_timers->armed) {
+        return;
+    }
+
+    s_timers->armed = next;
+    itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (next != TimerWheel::NoExpiry) {
+        its.it_value.tv_sec = next / 1000;
+        its.it_value.tv_nsec = (next % 1000) * 1000000;
+        if (next == 0) {
+            its.it_value.tv_nsec = 1;
+        }
+    }
+    timerfd_settime(s_timers->fd, TFD_TIMER_ABSTIME, &its, nullptr);
+}
+
+static void scheduleTimer(TimerWheel::Node *node, int msecs, int slack)
+{
+    uint64_t now = monotonicMsecs();
+    s_timers->wheel.reset(now);
+    s_timers->wheel.add(node, TimerWheel::applySlack(now + msecs, slack));
+    updateTimerFd();
+}
+
+static void initTimers()
+{
+    s_timers = new Timers;
+    s_timers->wheel.reset(monotonicMsecs());
+    s_timers->armed = TimerWheel::NoExpiry;
+    s_timers->fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (s_timers->fd < 0) {
+        qFatal("Couldn't create the timerfd: %s", strerror(errno));
+    }
+    s_timers->source = wl_event_loop_add_fd(s_event_loop, s_timers->fd, WL_EVENT_READABLE, [](int fd, uint32_t mask, void *data) {
+        uint64_t expirations;
+        ::read(fd, &expirations, sizeof(expirations));
+
+        // the timerfd is one shot, it is now disarmed
+        s_timers->armed = TimerWheel::NoExpiry;
+        uint64_t now = monotonicMsecs();
+        while (TimerWheel::Node *node = s_timers->wheel.takeExpired(now)) {
+            node->callback(node->data);
+        }
+        updateTimerFd();
+        return 0;
+    }, nullptr);
+}
+
+static void destroyTimers()
+{
+    close(s_timers->fd);
+    for (SingleShot *ss: s_timers->pool) {
+        delete ss;
+    }
+    delete s_timers;
+    s_timers = nullptr;
+}
+
 Timer::Timer()
      : m_func(nullptr)
-     , m_timerSource(nullptr)
      , m_idleSource(nullptr)
      , m_interval(-1)
+     , m_slack(-1)
      , m_repeat(true)
+     , m_name("timer")
 {
+    m_node.callback = [](void *data) {
+        Timer *t = static_cast<Timer *>(data);
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Timer, t->m_name);
+        t->timeout();
+    };
+    m_node.data = this;
 }
 
 Timer::~Timer()
@@ -76,9 +170,7 @@ Timer::~Timer()
         return;
     }
 
-    if (m_timerSource) {
-        wl_event_source_remove(m_timerSource);
-    }
+    s_timers->wheel.remove(&m_node);
     if (m_idleSource) {
         wl_event_source_remove(m_idleSource);
     }
@@ -89,6 +181,16 @@ void Timer::setRepeat(bool repeat)
     m_repeat = repeat;
 }
 
+void Timer::setSlack(int msecs)
+{
+    m_slack = msecs;
+}
+
+void Timer::setName(const char *name)
+{
+    m_name = name;
+}
+
 void Timer::setTimeoutHandler(const std::function<void ()> &func)
 {
     m_func = func;
@@ -103,14 +205,6 @@ void Timer::start(int msecs, const std::function<void ()> &func)
 void Timer::start(int msecs)
 {
     m_interval = msecs;
-
-    if (!m_timerSource) {
-        m_timerSource = wl_event_loop_add_timer(s_event_loop, [](void *data) {
-            Timer *t = static_cast<Timer *>(data);
-            t->timeout();
-            return 0;
-        }, this);
-    }
     rearm();
 }
 
@@ -133,6 +227,7 @@ void Timer::rearm()
     if (m_interval == 0 && !m_idleSource) {
         m_idleSource = wl_event_loop_add_idle(s_event_loop, [](void *data) {
             Timer *t = static_cast<Timer *>(data);
+            LoopMonitor::Scope scope(LoopMonitor::Kind::Idle, t->m_name);
             t->m_idleSource = nullptr;
             t->timeout();
         }, this);
@@ -141,7 +236,13 @@ void Timer::rearm()
         m_idleSource = nullptr;
     }
 
-    wl_event_source_timer_update(m_timerSource, m_interval < 0 ? 0 : m_interval);
+    if (m_interval > 0) {
+        // by default allow the timer to be late by ~0.4% of the interval
+        scheduleTimer(&m_node, m_interval, m_slack < 0 ? m_interval / 256 : m_slack);
+    } else if (m_node.isPending()) {
+        s_timers->wheel.remove(&m_node);
+        updateTimerFd();
+    }
 }
 
 void Timer::singleShot(int msecs, const std::function<void ()> &func)
@@ -150,34 +251,39 @@ void Timer::singleShot(int msecs, const std::function<void ()> &func)
         return;
     }
 
-    struct SingleShot {
-        std::function<void ()> func;
-        wl_event_source *source;
-    };
-
-    SingleShot *ss = new SingleShot{ func, nullptr };
+    SingleShot *ss;
+    if (s_timers->pool.empty()) {
+        ss = new SingleShot;
+        ss->node.data = ss;
+        ss->node.callback = [](void *data) {
+            LoopMonitor::Scope scope(LoopMonitor::Kind::Timer, "single shot");
+            auto *ss = static_cast<SingleShot *>(data);
+            auto func = std::move(ss->func);
+            ss->func = nullptr;
+            if (s_timers->pool.size() < 32) {
+                s_timers->pool.push_back(ss);
+            } else {
+                delete ss;
+            }
+            func();
+        };
+    } else {
+        ss = s_timers->pool.back();
+        s_timers->pool.pop_back();
+    }
+    ss->func = func;
 
     if (msecs == 0) {
         wl_event_loop_add_idle(s_event_loop, [](void *data) {
+            LoopMonitor::Scope scope(LoopMonitor::Kind::Idle, "single shot");
             auto *ss = static_cast<SingleShot *>(data);
-            ss->func();
-            delete ss;
+            ss->node.callback(ss);
         }, ss);
     } else {
-        ss->source = wl_event_loop_add_timer(s_event_loop, [](void *data) {
-            auto *ss = static_cast<SingleShot *>(data);
-            ss->func();
-            wl_event_source_remove(ss->source);
-            delete ss;
-            return 0;
-        }, ss);
-        wl_event_source_timer_update(ss->source, msecs);
+        scheduleTimer(&ss->node, msecs, msecs / 256);
     }
 }
 
-
-
-
 static int log(const char *fmt, va_list ap)
 {
     return vprintf(fmt, ap);
@@ -195,12 +301,11 @@ static void terminate_binding(weston_keyboard *keyb, uint32_t time, uint32_t key
 }
 
 struct Listener {
-    wl_listener listener;
     wl_listener outputCreatedSignal;
     wl_listener outputMovedSignal;
+    wl_listener outputResizedSignal;
     wl_listener sessionSignal;
     wl_listener seatCreatedSignal;
-    Compositor *compositor;
 };
 
 Compositor::Compositor(Backend *backend)
@@ -212,16 +317,22 @@ Compositor::Compositor(Backend *backend)
           , m_shell(nullptr)
           , m_bindingsCleanupHandler(new QObjectCleanupHandler)
           , m_authorizer(nullptr)
+          , m_viewIndex(nullptr)
+          , m_loopMonitor(nullptr)
+          , m_frameThrottle(nullptr)
 {
-    m_fakeRepaintLoopTimer.setTimeoutHandler([this]() {
-        fakeRepaint();
-    });
-
     if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalsFd)) {
         qFatal("Couldn't create signals socketpair");
     }
 
     s_event_loop = wl_display_get_event_loop(m_display);
+    initTimers();
+    if (EventDispatcher *dispatcher = EventDispatcher::instance()) {
+        dispatcher->attach(s_event_loop);
+        connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, [this]() {
+            wl_display_flush_clients(m_display);
+        });
+    }
     wl_event_loop_add_fd(s_event_loop, s_signalsFd[1], WL_EVENT_READABLE, [](int fd, uint32_t mask, void *data) {
         char tmp;
         ::read(fd, &tmp, sizeof(tmp));
@@ -265,20 +376,12 @@ Compositor::Compositor(Backend *backend)
     sigaction(SIGTERM, &sigterm, 0);
     sigaction(SIGALRM, &sigalrm, 0);
 
-    QString path = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
-    QString configFile = path + QLatin1String("/orbital/orbital.conf");
-
-    QFile file(configFile);
-    QByteArray data;
-    if (file.open(QIODevice::ReadOnly)) {
-        data = file.readAll();
-        file.close();
-    }
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    m_config = doc.object();
+    m_config.load();
+    m_loopMonitor = new LoopMonitor(m_display, m_config.longHandlerThreshold() * 1000);
 
     alarm(WATCHDOG_TIMEOUT);
+    m_watchdogTimer.setName("watchdog");
+    m_watchdogTimer.setSlack(1000);
     m_watchdogTimer.start(10000, [this]() {        alarm(WATCHDOG_TIMEOUT);        alarmFired = 0;    });
 }
 
@@ -298,17 +401,22 @@ Compositor::~Compositor()
 
     if (m_compositor)
         weston_compositor_destroy(m_compositor);
+    delete m_viewIndex;
+    m_viewIndex = nullptr;
+    delete m_frameThrottle;
     delete m_listener;
     delete m_backend;
 
+    delete m_loopMonitor;
+    if (EventDispatcher *dispatcher = EventDispatcher::instance()) {
+        dispatcher->detach();
+    }
+
     // we reset s_event_loop so that ~Timer() won't delete the event sources, since they are automatically
     // freed when the display is destroyed
     s_event_loop = nullptr;
     wl_display_destroy(m_display);
-}
-
-static void compositorDestroyed(wl_listener *listener, void *data)
-{
+    destroyTimers();
 }
 
 static const char xdg_error_message[] =
@@ -359,14 +467,17 @@ static const weston_pointer_grab_interface defaultPointerGrab = {
         Seat::fromSeat(p->seat)->pointer()->defaultGrabFocus();
     },
     [](weston_pointer_grab *grab, uint32_t time, weston_pointer_motion_event *event) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "pointer");
         Seat *seat = Seat::fromSeat(grab->pointer->seat);
         seat->pointer()->defaultGrabMotion(time, Pointer::MotionEvent(event));
     },
     [](weston_pointer_grab *grab, uint32_t time, uint32_t btn, uint32_t state) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "pointer");
         Seat *seat = Seat::fromSeat(grab->pointer->seat);
         seat->pointer()->defaultGrabButton(time, btn, state);
     },
     [](weston_pointer_grab *grab, uint32_t time, weston_pointer_axis_event *event) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "pointer");
         Seat *seat = Seat::fromSeat(grab->pointer->seat);
         seat->pointer()->defaultGrabAxis(time, Pointer::AxisEvent(event));
     },
@@ -393,66 +504,66 @@ bool Compositor::init(StringView socketName)
     }
 
     m_compositor->idle_time = 300;
+    m_viewIndex = new ViewIndex(this);
+    m_frameThrottle = new FrameThrottle(this);
 
-    QJsonObject kbdConfig = m_config[QStringLiteral("Compositor")].toObject()[QStringLiteral("Keyboard")].toObject();
-    const QByteArray keylayout = kbdConfig[QStringLiteral("Layout")].toString().toUtf8();
-    const QByteArray keyoptions = kbdConfig[QStringLiteral("Options")].toString().toUtf8();
-    const QByteArray keyvariant = kbdConfig[QStringLiteral("Variant")].toString().toUtf8();
-
-    m_defaultKeymap = Keymap(keylayout.isEmpty() ? Maybe<StringView>() : StringView(keylayout),
-                             keyoptions.isEmpty() ? Maybe<StringView>() : StringView(keyoptions),
-                             keyvariant.isEmpty() ? Maybe<StringView>() : StringView(keyvariant));
-
-    xkb_rule_names xkb = { nullptr, nullptr,
-                           keylayout.isEmpty() ? nullptr : strdup(keylayout.data()),
-                           keyvariant.isEmpty() ? nullptr : strdup(keyvariant.data()),
-                           keyoptions.isEmpty() ? nullptr : strdup(keyoptions.data()) };
-
-    if (weston_compositor_set_xkb_rule_names(m_compositor, &xkb) < 0)
+    if (!loadKeyboardConfig()) {
         return false;
+    }
 
     for (int i = 0; i <= (int)Layer::Minimized; ++i) {
         m_layers.emplace_back(&m_compositor->cursor_layer);
     }
     layer(Layer::Minimized)->setMask(0, 0, 0, 0);
 
-    m_compositor->kb_repeat_rate = 40;
-    m_compositor->kb_repeat_delay = 400;
     m_compositor->exit = terminate;
     m_compositor->vt_switching = true;
 
-    m_listener->compositor = this;
-    m_listener->listener.notify = compositorDestroyed;
-    wl_signal_add(&m_compositor->destroy_signal, &m_listener->listener);
     m_listener->outputMovedSignal.notify = [](wl_listener *l, void *data) {
         if (Output *o = Output::fromOutput(static_cast<weston_output *>(data))) {
             emit o->moved();
         }
     };
     wl_signal_add(&m_compositor->output_moved_signal, &m_listener->outputMovedSignal);
+    m_listener->outputResizedSignal.notify = [](wl_listener *l, void *data) {
+        if (Output *o = Output::fromOutput(static_cast<weston_output *>(data))) {
+            emit o->resized();
+        }
+    };
+    wl_signal_add(&m_compositor->output_resized_signal, &m_listener->outputResizedSignal);
     m_listener->outputCreatedSignal.notify = [](wl_listener *l, void *data) {
-        Listener *listener = wl_container_of(l, (Listener *)nullptr, outputCreatedSignal);
-        listener->compositor->newOutput(static_cast<weston_output *>(data));
+        weston_output *o = static_cast<weston_output *>(data);
+        fromCompositor(o->compositor)->newOutput(o);
     };
     wl_signal_add(&m_compositor->output_created_signal, &m_listener->outputCreatedSignal);
     m_listener->sessionSignal.notify = [](wl_listener *l, void *data) {
-        Listener *listener = wl_container_of(l, (Listener *)nullptr, sessionSignal);
-        emit listener->compositor->sessionActivated(listener->compositor->m_compositor->session_active);
+        weston_compositor *c = static_cast<weston_compositor *>(data);
+        emit fromCompositor(c)->sessionActivated(c->session_active);
     };
     wl_signal_add(&m_compositor->session_signal, &m_listener->sessionSignal);
     m_listener->seatCreatedSignal.notify = [](wl_listener *l, void *data)
     {
-        Listener *listener = wl_container_of(l, (Listener *)nullptr, seatCreatedSignal);
         weston_seat *s = static_cast<weston_seat *>(data);
-        emit listener->compositor->seatCreated(Seat::fromSeat(s));
+        Compositor *c = fromCompositor(s->compositor);
+        emit c->seatCreated(new Seat(c, s));
     };
     wl_signal_add(&m_compositor->seat_created_signal, &m_listener->seatCreatedSignal);
 //     text_backend_init(m_compositor, "");
 
-    if (!m_backend->init(m_compositor)) {
+    if (!m_backend->init(m_compositor, m_config)) {
         return false;
     }
 
+    m_config.outputsChanged.connect(this, &Compositor::outputsConfigChanged);
+    m_config.keyboardChanged.connect(this, &Compositor::keyboardConfigChanged);
+    auto setThrottleRates = [this]() {
+        const Config::FrameThrottle &cfg = m_config.frameThrottle();
+        m_frameThrottle->setRates(cfg.occluded, cfg.hidden, cfg.minimized);
+    };
+    setThrottleRates();
+    m_config.frameThrottleChanged.connect(setThrottleRates);
+    m_config.watch(s_event_loop);
+
     weston_pending_output_coldplug(m_compositor);
 
     const char *socket = nullptr;
@@ -482,9 +593,14 @@ bool Compositor::init(StringView socketName)
                           (weston_keyboard_modifier)(MODIFIER_CTRL | MODIFIER_ALT),
                           terminate_binding, this);
     weston_install_debug_key_binding(m_compositor, MODIFIER_SUPER);
-    weston_compositor_add_debug_binding(m_compositor, KEY_D, [](weston_keyboard *, uint32_t, uint32_t key, void *) {
+    weston_compositor_add_debug_binding(m_compositor, KEY_D, [](weston_keyboard *, uint32_t, uint32_t key, void *data) {
         Debug::toggleDebugOutput();
-    }, nullptr);
+        Compositor *c = static_cast<Compositor *>(data);
+        for (Output *o: c->outputs()) {
+            o->frameStats().dump(qPrintable(o->name()));
+        }
+        c->m_loopMonitor->dump();
+    }, this);
 
     weston_compositor_set_default_pointer_grab(m_compositor, &defaultPointerGrab);
 
@@ -496,11 +612,7 @@ bool Compositor::init(StringView socketName)
     }
 
     connect(this, &Compositor::sessionActivated, [this](bool a) {
-        if (!a) {
-            m_fakeRepaintLoopTimer.start(100);
-        } else {
-            m_fakeRepaintLoopTimer.stop();
-        }
+        m_frameThrottle->setSessionActive(a);
     });
 
     return true;
@@ -508,52 +620,149 @@ bool Compositor::init(StringView socketName)
 
 void Compositor::newOutput(weston_output *output)
 {
-    QJsonObject outputs = m_config[QStringLiteral("Compositor")].toObject()[QStringLiteral("Outputs")].toObject();
-    QJsonObject cfg = outputs[QString::fromUtf8(output->name)].toObject();
-    int x = output->x;
-    int y = output->y;
-    if (cfg.contains(QStringLiteral("x"))) {
-        x = cfg[QStringLiteral("x")].toInt();
-    }
-    if (cfg.contains(QStringLiteral("y"))) {
-        y = cfg[QStringLiteral("y")].toInt();
-    }
-    weston_output_move(output, x, y);
+    configureOutput(output);
 
+    uint64_t start = monotonicMsecs();
     Output *o = new Output(output);
     connect(o, &QObject::destroyed, this, &Compositor::outputDestroyed);
     m_outputs.push_back(o);
 
     emit outputCreated(o);
+    qDebug("Output %s set up in %llu ms", output->name, (unsigned long long)(monotonicMsecs() - start));
 }
 
-//XXX FIXME This comes from compositor.c, it should not stay here!!
-struct weston_frame_callback {
-    struct wl_resource *resource;
-    struct wl_list link;
-};
+bool Compositor::loadKeyboardConfig()
+{
+    const Config::Keyboard &kbd = m_config.keyboard();
 
-void Compositor::fakeRepaint()
+    m_defaultKeymap = Keymap(kbd.layout.isEmpty() ? Maybe<StringView>() : StringView(kbd.layout),
+                             kbd.options.isEmpty() ? Maybe<StringView>() : StringView(kbd.options),
+                             kbd.variant.isEmpty() ? Maybe<StringView>() : StringView(kbd.variant));
+
+    // weston keeps the names and only frees them on exit, so free the
+    // ones of the previous load before replacing them
+    xkb_rule_names &old = m_compositor->xkb_names;
+    for (const char *name: { old.rules, old.model, old.layout, old.variant, old.options }) {
+        free(const_cast<char *>(name));
+    }
+    old = xkb_rule_names();
+
+    xkb_rule_names xkb = { nullptr, nullptr,
+                           kbd.layout.isEmpty() ? nullptr : strdup(kbd.layout.data()),
+                           kbd.variant.isEmpty() ? nullptr : strdup(kbd.variant.data()),
+                           kbd.options.isEmpty() ? nullptr : strdup(kbd.options.data()) };
+
+    m_compositor->kb_repeat_rate = kbd.repeatRate;
+    m_compositor->kb_repeat_delay = kbd.repeatDelay;
+
+    return weston_compositor_set_xkb_rule_names(m_compositor, &xkb) == 0;
+}
+
+static weston_mode *findMode(weston_output *output, const QString &str)
 {
-    wl_list frame_callback_list;
-    wl_list_init(&frame_callback_list);
-    weston_view *view;
-    wl_list_for_each(view, &m_compositor->view_list, link) {
-        wl_list_insert_list(&frame_callback_list, &view->surface->frame_callback_list);
-        wl_list_init(&view->surface->frame_callback_list);
+    weston_mode *mode;
+    if (str == QStringLiteral("preferred")) {
+        wl_list_for_each(mode, &output->mode_list, link) {
+            if (mode->flags & WL_OUTPUT_MODE_PREFERRED) {
+                return mode;
+            }
+        }
+        return nullptr;
     }
 
-    weston_frame_callback *cb, *cnext;
-    wl_list_for_each_safe(cb, cnext, &frame_callback_list, link) {
-        wl_callback_send_done(cb->resource, 0);
-        wl_resource_destroy(cb->resource);
+    // Only the WIDTHxHEIGHT[@REFRESH] form is matched here, modelines can
+    // only be used when the output is created
+    QStringList parts = str.split(QLatin1Char('@'));
+    QStringList size = parts.first().split(QLatin1Char('x'));
+    if (size.count() != 2) {
+        return nullptr;
     }
+    int width = size.at(0).toInt();
+    int height = size.at(1).toInt();
+    int refresh = parts.count() > 1 ? qRound(parts.at(1).toDouble() * 1000) : 0;
+
+    weston_mode *best = nullptr;
+    wl_list_for_each(mode, &output->mode_list, link) {
+        if (mode->width != width || mode->height != height) {
+            continue;
+        }
+        if (refresh && qAbs(mode->refresh - refresh) < 1000) {
+            return mode;
+        }
+        if (!best || mode->refresh > best->refresh) {
+            best = mode;
+        }
+    }
+    return refresh ? nullptr : best;
+}
+
+void Compositor::configureOutput(weston_output *output)
+{
+    Config::Output cfg = m_config.output(QString::fromUtf8(output->name));
+
+    if (!cfg.mode.isEmpty() && cfg.mode != QStringLiteral("current") && cfg.mode != QStringLiteral("off")) {
+        weston_mode *mode = findMode(output, cfg.mode);
+        int scale = cfg.scale ? cfg.scale.value() : output->current_scale;
+        if (mode && (mode != output->current_mode || scale != output->current_scale)) {
+            weston_output_mode_set_native(output, mode, scale);
+        }
+    } else if (cfg.scale && cfg.scale.value() != output->current_scale) {
+        weston_output_mode_set_native(output, output->current_mode, cfg.scale.value());
+    }
+
+    int x = cfg.x ? cfg.x.value() : output->x;
+    int y = cfg.y ? cfg.y.value() : output->y;
+    if (x != output->x || y != output->y) {
+        weston_output_move(output, x, y);
+    }
+}
+
+void Compositor::outputsConfigChanged()
+{
+    for (Output *o: m_outputs) {
+        configureOutput(o->output());
+    }
+}
+
+void Compositor::keyboardConfigChanged()
+{
+    if (!loadKeyboardConfig()) {
+        qWarning("Failed to apply the new keyboard configuration");
+        return;
+    }
+
+    for (Seat *s: seats()) {
+        s->reloadKeymap();
+
+        weston_keyboard *keyboard = weston_seat_get_keyboard(s->westonSeat());
+        if (!keyboard) {
+            continue;
+        }
+        wl_resource *resource;
+        auto sendRepeatInfo = [this](wl_resource *r) {
+            if (wl_resource_get_version(r) >= WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
+                wl_keyboard_send_repeat_info(r, m_compositor->kb_repeat_rate, m_compositor->kb_repeat_delay);
+            }
+        };
+        wl_resource_for_each(resource, &keyboard->resource_list) {
+            sendRepeatInfo(resource);
+        }
+        wl_resource_for_each(resource, &keyboard->focus_resource_list) {
+            sendRepeatInfo(resource);
+        }
+    }
+}
+
+void Compositor::run()
+{
+    // The Qt event dispatcher runs the wl_event_loop, see EventDispatcher
+    QCoreApplication::exec();
 }
 
 void Compositor::quit()
 {
     qDebug() << "Orbital exiting...";
-    wl_display_terminate(m_display);
+    QCoreApplication::quit();
 }
 
 Shell *Compositor::shell() const
@@ -590,15 +799,32 @@ View *Compositor::pickView(double x, double y, double *vx, double *vy) const
 {
     wl_fixed_t fx = wl_fixed_from_double(x);
     wl_fixed_t fy = wl_fixed_from_double(y);
-    wl_fixed_t fvx, fvy;
-    weston_view *v = weston_compositor_pick_view(m_compositor, fx, fy, &fvx, &fvy);
+    int ix = wl_fixed_to_int(fx);
+    int iy = wl_fixed_to_int(fy);
+    wl_fixed_t fvx = wl_fixed_from_int(-1000000);
+    wl_fixed_t fvy = wl_fixed_from_int(-1000000);
+
+    View *view = nullptr;
+    for (View *v: m_viewIndex->candidates(ix, iy)) {
+        weston_view *wv = v->m_view;
+        if (!pixman_region32_contains_point(&wv->transform.boundingbox, ix, iy, NULL)) {
+            continue;
+        }
+
+        weston_view_from_global_fixed(wv, fx, fy, &fvx, &fvy);
+        if (pixman_region32_contains_point(&wv->surface->input, wl_fixed_to_int(fvx), wl_fixed_to_int(fvy), NULL)) {
+            view = v;
+            break;
+        }
+        fvx = fvy = wl_fixed_from_int(-1000000);
+    }
 
     if (vx)
         *vx = wl_fixed_to_double(fvx);
     if (vy)
         *vy = wl_fixed_to_double(fvy);
 
-    return View::fromView(v);
+    return view;
 }
 
 ChildProcess *Compositor::launchProcess(StringView path)
@@ -661,9 +887,7 @@ void Compositor::handleHotSpot(Seat *seat, uint32_t time, PointerHotSpot hs)
 
 Compositor *Compositor::fromCompositor(weston_compositor *c)
 {
-    wl_listener *listener = wl_signal_get(&c->destroy_signal, compositorDestroyed);
-    Q_ASSERT(listener);
-    return reinterpret_cast<Listener *>(listener)->compositor;
+    return static_cast<Compositor *>(weston_compositor_get_user_data(c));
 }
 
 void Compositor::outputDestroyed()
@@ -673,7 +897,10 @@ void Compositor::outputDestroyed()
     if (i != m_outputs.end()) {
         m_outputs.erase(i);
     }
+    uint64_t start = monotonicMsecs();
     emit outputRemoved(o);
+    // the Output is already being destroyed, don't ask it its name
+    qDebug("Output removed in %llu ms", (unsigned long long)(monotonicMsecs() - start));
 }
 
 
@@ -729,29 +956,13 @@ void ChildProcess::start()
     int sv[2];
     socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv);
 
-    class Process : public QProcess
-    {
-    public:
-        Process(int fd) : QProcess(), socket(fd) {}
-        void setupChildProcess() override
-        {
-            // 'socket' has SOCK_CLOEXEC, so it will be closed on exec. dup it to carry it on
-            int fd = dup(socket);
-            setenv("WAYLAND_SOCKET", qPrintable(QString::number(fd)), 1);
-            setpriority(PRIO_PROCESS, getpid(), 0);
-        }
-
-        int socket;
-    };
-
-    Process *process = new Process(sv[1]);
-    connect(process, (void (QProcess::*)(QProcess::ProcessError))&QProcess::error, [this](QProcess::ProcessError err) {
-        fmt::print("{}: error {}", m_program, (int)err);
-    });
-    process->setProcessChannelMode(QProcess::ForwardedChannels);
-    process->start(QString::fromStdString(m_program));
+    // The exit of the process is noticed through the destruction of its client,
+    // the Process only needs to reap it
+    Process process(wl_display_get_event_loop(m_display));
+    process.setProgram(m_program);
+    process.setEnvironment("WAYLAND_SOCKET", std::to_string(process.passFd(sv[1])));
+    process.start();
     close(sv[1]);
-    connect(process, (void (QProcess::*)(int))&QProcess::finished, process, &QObject::deleteLater);
 
     m_client = wl_client_create(m_display, sv[0]);
     if (!m_client) {
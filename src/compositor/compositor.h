@@ -24,8 +24,8 @@
 #include <unordered_map>
 
 #include <QObject>
-#include <QJsonObject>
 
+#include "config.h"
 #include "global.h"
 #include "interface.h"
 #include "stringview.h"
@@ -38,7 +38,6 @@ struct weston_compositor;
 struct weston_surface;
 struct weston_output;
 
-class QProcess;
 class QObjectCleanupHandler;
 
 namespace Orbital {
@@ -57,6 +56,9 @@ class AxisBinding;
 class HotSpotBinding;
 class Surface;
 class Authorizer;
+class ViewIndex;
+class LoopMonitor;
+class FrameThrottle;
 struct Listener;
 enum class PointerButton : unsigned char;
 enum class PointerAxis : unsigned char;
@@ -84,6 +86,7 @@ public:
     ~Compositor();
 
     bool init(StringView socket);
+    void run();
     void quit();
 
     inline wl_display *display() const { return m_display; }
@@ -92,10 +95,13 @@ public:
     const std::vector<Output *> &outputs() const;
     std::vector<Seat *> seats() const;
     const Keymap &defaultKeymap() const { return m_defaultKeymap; }
+    const Config &config() const { return m_config; }
 
     uint32_t nextSerial() const;
 
     View *pickView(double x, double y, double *vx = nullptr, double *vy = nullptr) const;
+    ViewIndex *viewIndex() const { return m_viewIndex; }
+    FrameThrottle *frameThrottle() const { return m_frameThrottle; }
     ChildProcess *launchProcess(StringView path);
 
     Authorizer *authorizer() const { return m_authorizer; }
@@ -122,7 +128,10 @@ signals:
 private:
     void outputDestroyed();
     void newOutput(weston_output *o);
-    void fakeRepaint();
+    bool loadKeyboardConfig();
+    void configureOutput(weston_output *output);
+    void outputsConfigChanged();
+    void keyboardConfigChanged();
 
     wl_display *m_display;
     wl_event_loop *m_loop;
@@ -132,13 +141,15 @@ private:
     Shell *m_shell;
     std::vector<Orbital::Layer> m_layers;
     std::vector<Output *> m_outputs;
-    Timer m_fakeRepaintLoopTimer;
     Timer m_watchdogTimer;
     QObjectCleanupHandler *m_bindingsCleanupHandler;
-    QJsonObject m_config;
+    Config m_config;
     std::unordered_multimap<int, HotSpotBinding *> m_hotSpotBindings;
     Keymap m_defaultKeymap;
     Authorizer *m_authorizer;
+    ViewIndex *m_viewIndex;
+    LoopMonitor *m_loopMonitor;
+    FrameThrottle *m_frameThrottle;
 
     friend class Global;
     friend class RestrictedGlobal;
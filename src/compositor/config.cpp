@@ -0,0 +1,226 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#include <wayland-server.h>
+
+#include "config.h"
+
+namespace Orbital {
+
+static bool operator==(const Maybe<int> &a, const Maybe<int> &b)
+{
+    return a.isSet() == b.isSet() && (!a.isSet() || a.value() == b.value());
+}
+
+static bool operator==(const Config::Output &a, const Config::Output &b)
+{
+    return a.x == b.x && a.y == b.y && a.scale == b.scale && a.mode == b.mode;
+}
+
+static bool operator==(const Config::Keyboard &a, const Config::Keyboard &b)
+{
+    return a.layout == b.layout && a.options == b.options && a.variant == b.variant &&
+           a.repeatRate == b.repeatRate && a.repeatDelay == b.repeatDelay;
+}
+
+static bool operator==(const Config::FrameThrottle &a, const Config::FrameThrottle &b)
+{
+    return a.occluded == b.occluded && a.hidden == b.hidden && a.minimized == b.minimized;
+}
+
+static Maybe<int> intValue(const QJsonObject &obj, const QString &key)
+{
+    QJsonValue v = obj[key];
+    return v.isDouble() ? Maybe<int>(v.toInt()) : Maybe<int>();
+}
+
+Config::Config()
+      : m_inotifyFd(-1)
+      , m_watch(-1)
+      , m_source(nullptr)
+      , m_keyboard({ QByteArray(), QByteArray(), QByteArray(), 40, 400 })
+      , m_frameThrottle({ 1, 1, 0 })
+      , m_longHandlerThreshold(10)
+      , m_desktopGridSnapshots(true)
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
+    m_path = path + QLatin1String("/orbital/orbital.conf");
+}
+
+Config::~Config()
+{
+    if (m_source) {
+        wl_event_source_remove(m_source);
+    }
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+    }
+}
+
+bool Config::load()
+{
+    QFile file(m_path);
+    QByteArray data;
+    if (file.open(QIODevice::ReadOnly)) {
+        data = file.readAll();
+        file.close();
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+    if (!data.isEmpty() && doc.isNull()) {
+        qWarning("Failed to parse '%s': %s", qPrintable(m_path), qPrintable(error.errorString()));
+        return false;
+    }
+
+    QJsonObject compositor = doc.object()[QStringLiteral("Compositor")].toObject();
+
+    QHash<QString, Output> outputs;
+    QJsonObject outputsConfig = compositor[QStringLiteral("Outputs")].toObject();
+    for (auto it = outputsConfig.begin(); it != outputsConfig.end(); ++it) {
+        QJsonObject cfg = it.value().toObject();
+        Output &output = outputs[it.key()];
+        output.x = intValue(cfg, QStringLiteral("x"));
+        output.y = intValue(cfg, QStringLiteral("y"));
+        output.scale = intValue(cfg, QStringLiteral("scale"));
+        output.mode = cfg[QStringLiteral("mode")].toString();
+    }
+
+    QJsonObject kbdConfig = compositor[QStringLiteral("Keyboard")].toObject();
+    Keyboard keyboard;
+    keyboard.layout = kbdConfig[QStringLiteral("Layout")].toString().toUtf8();
+    keyboard.options = kbdConfig[QStringLiteral("Options")].toString().toUtf8();
+    keyboard.variant = kbdConfig[QStringLiteral("Variant")].toString().toUtf8();
+    keyboard.repeatRate = kbdConfig[QStringLiteral("RepeatRate")].toInt(40);
+    keyboard.repeatDelay = kbdConfig[QStringLiteral("RepeatDelay")].toInt(400);
+
+    QJsonObject throttleConfig = compositor[QStringLiteral("FrameThrottle")].toObject();
+    FrameThrottle throttle;
+    throttle.occluded = qMax(0, throttleConfig[QStringLiteral("Occluded")].toInt(1));
+    throttle.hidden = qMax(0, throttleConfig[QStringLiteral("Hidden")].toInt(1));
+    throttle.minimized = qMax(0, throttleConfig[QStringLiteral("Minimized")].toInt(0));
+
+    m_longHandlerThreshold = compositor[QStringLiteral("LongHandlerThreshold")].toInt(10);
+    m_desktopGridSnapshots = compositor[QStringLiteral("DesktopGridSnapshots")].toBool(true);
+
+    bool outputsChange = outputs != m_outputs;
+    bool keyboardChange = !(keyboard == m_keyboard);
+    bool throttleChange = !(throttle == m_frameThrottle);
+    m_outputs = outputs;
+    m_keyboard = keyboard;
+    m_frameThrottle = throttle;
+
+    if (outputsChange) {
+        outputsChanged();
+    }
+    if (keyboardChange) {
+        keyboardChanged();
+    }
+    if (throttleChange) {
+        frameThrottleChanged();
+    }
+    return true;
+}
+
+void Config::watch(wl_event_loop *loop)
+{
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0) {
+        qWarning("Cannot watch '%s' for changes: %s", qPrintable(m_path), strerror(errno));
+        return;
+    }
+    addWatch();
+
+    m_source = wl_event_loop_add_fd(loop, m_inotifyFd, WL_EVENT_READABLE, [](int fd, uint32_t mask, void *data) {
+        static_cast<Config *>(data)->fileChanged();
+        return 0;
+    }, this);
+}
+
+// Watch the directory rather than the file, since editors usually replace
+// the file instead of writing it in place. If the directory doesn't exist yet
+// watch the nearest parent that does, until it is created.
+void Config::addWatch()
+{
+    QString dir = QFileInfo(m_path).absolutePath();
+    while (!QFileInfo(dir).isDir() && dir != QLatin1String("/")) {
+        dir = QFileInfo(dir).absolutePath();
+    }
+    if (dir == m_watchedDir) {
+        return;
+    }
+
+    if (m_watch >= 0) {
+        inotify_rm_watch(m_inotifyFd, m_watch);
+    }
+    m_watch = inotify_add_watch(m_inotifyFd, qPrintable(dir), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+    if (m_watch < 0) {
+        qWarning("Cannot watch '%s' for changes: %s", qPrintable(dir), strerror(errno));
+        m_watchedDir.clear();
+        return;
+    }
+    m_watchedDir = dir;
+}
+
+void Config::fileChanged()
+{
+    const QByteArray name = QFileInfo(m_path).fileName().toLocal8Bit();
+    const bool watchingParent = m_watchedDir != QFileInfo(m_path).absolutePath();
+
+    alignas(inotify_event) char buf[4096];
+    bool changed = false;
+    bool dirCreated = false;
+    ssize_t len;
+    while ((len = read(m_inotifyFd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            auto *event = reinterpret_cast<inotify_event *>(p);
+            if (event->len && !watchingParent && name == event->name) {
+                changed = true;
+            } else if (watchingParent && event->mask & IN_ISDIR) {
+                dirCreated = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    if (dirCreated) {
+        addWatch();
+        // the file may have been written before the new watch was in place
+        changed = QFileInfo(m_path).exists();
+    }
+
+    if (changed) {
+        qDebug("Configuration file changed, reloading it");
+        load();
+    }
+}
+
+}
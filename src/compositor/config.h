@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_CONFIG_H
+#define ORBITAL_CONFIG_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+#include "utils.h"
+
+struct wl_event_loop;
+struct wl_event_source;
+
+namespace Orbital {
+
+/**
+ * The compositor configuration, parsed once from orbital.conf and shared
+ * with the backends. The accessors are inline so that the backend plugins
+ * can use them.
+ * When watched the file is parsed again whenever it changes, and the
+ * signals of the sections that changed are emitted.
+ */
+class Config
+{
+public:
+    struct Output {
+        Maybe<int> x;
+        Maybe<int> y;
+        Maybe<int> scale;
+        // "preferred", "current", "off", a modeline or empty if unset
+        QString mode;
+    };
+    struct Keyboard {
+        QByteArray layout;
+        QByteArray options;
+        QByteArray variant;
+        int repeatRate;
+        int repeatDelay;
+    };
+    // Rates in Hz at which the frame callbacks of the surfaces that are
+    // not visible are sent, 0 to hold them until they become visible
+    struct FrameThrottle {
+        int occluded;
+        int hidden;
+        int minimized;
+    };
+
+    Config();
+    ~Config();
+
+    QString path() const { return m_path; }
+    bool load();
+    void watch(wl_event_loop *loop);
+
+    Output output(const QString &name) const { return m_outputs.value(name); }
+    const Keyboard &keyboard() const { return m_keyboard; }
+    const FrameThrottle &frameThrottle() const { return m_frameThrottle; }
+    int longHandlerThreshold() const { return m_longHandlerThreshold; }
+    // Whether the desktop grid shows the inactive workspaces as pictures
+    bool desktopGridSnapshots() const { return m_desktopGridSnapshots; }
+
+    Signal<> outputsChanged;
+    Signal<> keyboardChanged;
+    Signal<> frameThrottleChanged;
+
+private:
+    void fileChanged();
+    void addWatch();
+
+    QString m_path;
+    int m_inotifyFd;
+    int m_watch;
+    QString m_watchedDir;
+    wl_event_source *m_source;
+    QHash<QString, Output> m_outputs;
+    Keyboard m_keyboard;
+    FrameThrottle m_frameThrottle;
+    int m_longHandlerThreshold;
+    bool m_desktopGridSnapshots;
+};
+
+}
+
+#endif
@@ -37,6 +37,7 @@ public:
         , m_layer(new Layer(c->layer(Compositor::Layer::Dashboard)))
     {
         m_layer->setAcceptInput(false);
+        o->addCoveredLayer(m_layer, c->layer(Compositor::Layer::Dashboard));
     }
 
     void configure(Orbital::View *view)
@@ -18,6 +18,7 @@
  */
 
 #include <unistd.h>
+#include <string.h>
 
 #include <QDebug>
 #include <QFileInfo>
@@ -37,6 +38,7 @@
 #include "../fmt/format.h"
 #include "../fmt/ostream.h"
 #include "../surface.h"
+#include "../thumbnail.h"
 #include "desktopfile.h"
 
 #include "wayland-desktop-shell-server-protocol.h"
@@ -49,7 +51,17 @@ DesktopShellWindow::DesktopShellWindow(DesktopShell *ds)
                   , m_resource(nullptr)
                   , m_state(DESKTOP_SHELL_WINDOW_STATE_INACTIVE)
                   , m_sendState(true)
+                  , m_thumbnail(nullptr)
 {
+    m_thumbnailBuffer.resource = nullptr;
+    m_thumbnailBuffer.window = this;
+    m_thumbnailBuffer.destroyListener.notify = [](wl_listener *l, void *) {
+        auto *buffer = wl_container_of(l, (ThumbnailBuffer *)nullptr, destroyListener);
+        buffer->window->releaseThumbnailBuffer();
+        if (buffer->window->m_thumbnail) {
+            buffer->window->m_thumbnail->cancel();
+        }
+    };
 }
 
 DesktopShellWindow::~DesktopShellWindow()
@@ -133,9 +145,11 @@ void DesktopShellWindow::create()
         wrapInterface(close),
         wrapInterface(preview),
         wrapInterface(endPreview),
+        wrapInterface(setThumbnailBuffer),
     };
 
-    m_resource = wl_resource_create(m_desktopShell->client(), &desktop_shell_window_interface, 1, 0);
+    int version = wl_resource_get_version(m_desktopShell->resource());
+    m_resource = wl_resource_create(m_desktopShell->client(), &desktop_shell_window_interface, version, 0);
     wl_resource_set_implementation(m_resource, &implementation, this, [](wl_resource *res) {
         DesktopShellWindow *win = static_cast<DesktopShellWindow *>(wl_resource_get_user_data(res));
         win->m_resource = nullptr;
@@ -183,6 +197,10 @@ void DesktopShellWindow::create()
 
 void DesktopShellWindow::destroy()
 {
+    releaseThumbnailBuffer();
+    delete m_thumbnail;
+    m_thumbnail = nullptr;
+
     if (m_resource) {
         desktop_shell_window_send_removed(m_resource);
         wl_resource_set_implementation(m_resource, nullptr, nullptr, nullptr);
@@ -220,8 +238,7 @@ void DesktopShellWindow::setState(wl_client *client, wl_resource *resource, wl_r
     if (state & DESKTOP_SHELL_WINDOW_STATE_ACTIVE && !(state & DESKTOP_SHELL_WINDOW_STATE_MINIMIZED)) {
         s->workspace()->activate(Output::fromResource(output));
         scope->activate(s->surface());
-        for (Output *o: m_desktopShell->compositor()->outputs()) {
-            ShellView *view = s->viewForOutput(o);
+        for (ShellView *view: s->views()) {
             if (Layer *layer = view->layer()) {
                 layer->raiseOnTop(view);
             }
@@ -247,4 +264,65 @@ void DesktopShellWindow::endPreview(wl_resource *output)
     shsurf()->endPreview(Output::fromResource(output));
 }
 
+void DesktopShellWindow::setThumbnailBuffer(wl_client *client, wl_resource *resource, wl_resource *buffer)
+{
+    releaseThumbnailBuffer();
+    if (!buffer) {
+        delete m_thumbnail;
+        m_thumbnail = nullptr;
+        return;
+    }
+
+    wl_shm_buffer *shm = wl_shm_buffer_get(buffer);
+    uint32_t format = shm ? wl_shm_buffer_get_format(shm) : 0;
+    if (!shm || (format != WL_SHM_FORMAT_ARGB8888 && format != WL_SHM_FORMAT_XRGB8888)) {
+        wl_resource_post_error(resource, WL_DISPLAY_ERROR_INVALID_OBJECT, "the thumbnail buffer must be a ARGB8888 or XRGB8888 wl_shm buffer");
+        return;
+    }
+
+    m_thumbnailBuffer.resource = buffer;
+    wl_resource_add_destroy_listener(buffer, &m_thumbnailBuffer.destroyListener);
+
+    if (!m_thumbnail) {
+        m_thumbnail = new Thumbnail(shsurf());
+        connect(m_thumbnail, &Thumbnail::updated, this, &DesktopShellWindow::sendThumbnail);
+    }
+    // each buffer gets a thumbnail scaled to its own size
+    m_thumbnail->request(QSize(wl_shm_buffer_get_width(shm), wl_shm_buffer_get_height(shm)));
+}
+
+void DesktopShellWindow::sendThumbnail()
+{
+    if (!m_resource || !m_thumbnailBuffer.resource) {
+        return;
+    }
+
+    wl_shm_buffer *shm = wl_shm_buffer_get(m_thumbnailBuffer.resource);
+    const QImage &image = m_thumbnail->image();
+    const int width = image.width();
+    const int height = image.height();
+    const int stride = wl_shm_buffer_get_stride(shm);
+    if (width > wl_shm_buffer_get_width(shm) || height > wl_shm_buffer_get_height(shm)) {
+        return;
+    }
+
+    wl_shm_buffer_begin_access(shm);
+    uchar *data = static_cast<uchar *>(wl_shm_buffer_get_data(shm));
+    for (int y = 0; y < height; ++y) {
+        memcpy(data + y * stride, image.constScanLine(y), width * 4);
+    }
+    wl_shm_buffer_end_access(shm);
+
+    releaseThumbnailBuffer();
+    desktop_shell_window_send_thumbnail(m_resource, width, height);
+}
+
+void DesktopShellWindow::releaseThumbnailBuffer()
+{
+    if (m_thumbnailBuffer.resource) {
+        wl_list_remove(&m_thumbnailBuffer.destroyListener.link);
+        m_thumbnailBuffer.resource = nullptr;
+    }
+}
+
 }
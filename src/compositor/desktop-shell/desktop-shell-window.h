@@ -29,6 +29,7 @@ namespace Orbital {
 class ShellSurface;
 class DesktopShell;
 class Seat;
+class Thumbnail;
 
 class DesktopShellWindow : public Interface
 {
@@ -57,11 +58,20 @@ private:
     void close(wl_client *client, wl_resource *resource);
     void preview(wl_resource *output);
     void endPreview(wl_resource *output);
+    void setThumbnailBuffer(wl_client *client, wl_resource *resource, wl_resource *buffer);
+    void sendThumbnail();
+    void releaseThumbnailBuffer();
 
     DesktopShell *m_desktopShell;
     wl_resource *m_resource;
     int32_t m_state;
     bool m_sendState;
+    Thumbnail *m_thumbnail;
+    struct ThumbnailBuffer {
+        wl_listener destroyListener;
+        wl_resource *resource;
+        DesktopShellWindow *window;
+    } m_thumbnailBuffer;
 };
 
 }
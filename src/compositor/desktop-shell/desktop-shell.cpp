@@ -51,7 +51,7 @@ namespace Orbital {
 
 DesktopShell::DesktopShell(Shell *shell)
             : Interface(shell)
-            , Global(shell->compositor(), &desktop_shell_interface, 1)
+            , Global(shell->compositor(), &desktop_shell_interface, 2)
             , m_shell(shell)
             , m_resource(nullptr)
             , m_grabView(nullptr)
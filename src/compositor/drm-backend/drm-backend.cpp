@@ -21,14 +21,11 @@
 #include <gbm.h>
 
 #include <QDebug>
-#include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QStandardPaths>
 
 #include <compositor-drm.h>
 
 #include "drm-backend.h"
+#include "config.h"
 
 namespace Orbital {
 
@@ -58,21 +55,8 @@ static void configureDevice(struct weston_compositor *compositor, struct libinpu
 //     }
 }
 
-bool DrmBackend::init(weston_compositor *c)
+bool DrmBackend::init(weston_compositor *c, const Config &cfg)
 {
-    QString path = QStandardPaths::writableLocation(QStandardPaths::ConfigLocation);
-    QString configFile = path + QLatin1String("/orbital/orbital.conf");
-
-    QFile file(configFile);
-    QByteArray data;
-    if (file.open(QIODevice::ReadOnly)) {
-        data = file.readAll();
-        file.close();
-    }
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    auto outputs = doc.object()[QStringLiteral("Compositor")].toObject()[QStringLiteral("Outputs")].toObject();
-
     weston_drm_backend_config config;
     config.base.struct_version = WESTON_DRM_BACKEND_CONFIG_VERSION;
     config.base.struct_size = sizeof(config);
@@ -93,31 +77,24 @@ bool DrmBackend::init(weston_compositor *c)
         return false;
     }
 
-    m_pendingListener.setNotify([api, outputs](Listener *, void *data) {
+    m_pendingListener.setNotify([api, &cfg](Listener *, void *data) {
         auto output = static_cast<weston_output *>(data);
 
         int scale = 1;
         weston_drm_backend_output_mode mode = WESTON_DRM_BACKEND_OUTPUT_PREFERRED;
         QString modeline;
 
-        QJsonValue configValue = outputs[QLatin1String(output->name)];
-        if (!configValue.isUndefined()) {
-            QJsonObject config = configValue.toObject();
-
-            QString modeString = config[QStringLiteral("mode")].toString();
-            if (modeString == QStringLiteral("off")) {
-                weston_output_disable(output);
-                return;
-            } else if (modeString == QStringLiteral("current")) {
-                mode = WESTON_DRM_BACKEND_OUTPUT_CURRENT;
-            } else if (modeString != QStringLiteral("preferred")) {
-                modeline = modeString;
-            }
-
-            auto scalevalue = config[QStringLiteral("scale")];
-            if (scalevalue.isDouble()) {
-                scale = scalevalue.toInt();
-            }
+        Config::Output config = cfg.output(QString::fromUtf8(output->name));
+        if (config.mode == QStringLiteral("off")) {
+            weston_output_disable(output);
+            return;
+        } else if (config.mode == QStringLiteral("current")) {
+            mode = WESTON_DRM_BACKEND_OUTPUT_CURRENT;
+        } else if (config.mode != QStringLiteral("preferred")) {
+            modeline = config.mode;
+        }
+        if (config.scale) {
+            scale = config.scale.value();
         }
 
         if (api->set_mode(output, mode, qPrintable(modeline)) < 0) {
@@ -33,7 +33,7 @@ class DrmBackend : public Backend
 public:
     DrmBackend();
 
-    bool init(weston_compositor *c) override;
+    bool init(weston_compositor *c, const Config &config) override;
 
 private:
     Listener m_pendingListener;
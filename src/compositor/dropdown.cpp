@@ -51,6 +51,7 @@ public:
         , m_forceReposition(false)
         , m_firstShow(true)
         , m_layer(std::make_unique<Layer>(shell->compositor()->layer(Compositor::Layer::Sticky)))
+        , m_coveringOutput(nullptr)
     {
         wl_resource_set_implementation(resource, nullptr, this, [](wl_resource *res) {
             DropdownSurface *ds = static_cast<DropdownSurface *>(wl_resource_get_user_data(res));
@@ -75,9 +76,25 @@ public:
     {
         dropdown->m_surface = nullptr;
         wl_resource_set_destructor(resource, nullptr);
+        setCoveringOutput(nullptr);
+    }
+    // A fullscreen view on the output covers the dropdown, while it is masked to it
+    void setCoveringOutput(Output *o)
+    {
+        if (m_coveringOutput == o) {
+            return;
+        }
+        if (m_coveringOutput) {
+            m_coveringOutput->removeCoveredLayer(m_layer.get());
+        }
+        m_coveringOutput = o;
+        if (o) {
+            o->addCoveredLayer(m_layer.get(), shell->compositor()->layer(Compositor::Layer::Sticky));
+        }
     }
     void addInOutput(Output *o)
     {
+        setCoveringOutput(o);
         m_layer->setMask(o->x(), o->y(), o->width(), o->height());
         m_layer->addView(view);
         view->setTransformParent(o->rootView());
@@ -205,6 +222,7 @@ public:
         };
 
         view->setTransformParent(nullptr);
+        setCoveringOutput(nullptr);
         m_layer->unsetMask();
         view->setPos(view->pos() + m_output->rootView()->pos());
         view->update();
@@ -220,6 +238,10 @@ public:
     }
     void outputRemoved(Output *o)
     {
+        if (m_coveringOutput == o) {
+            // it is already gone and it relinked the layer itself
+            m_coveringOutput = nullptr;
+        }
         if (m_output == o) {
             setOutput(dropdown->m_shell->selectPrimaryOutput());
             updateGeometry();
@@ -241,6 +263,7 @@ public:
     bool m_forceReposition;
     bool m_firstShow;
     std::unique_ptr<Layer> m_layer;
+    Output *m_coveringOutput;
 };
 
 Dropdown::Dropdown(Shell *shell)
@@ -19,7 +19,12 @@
 
 #include <linux/input.h>
 
+#include <vector>
+
 #include <QDebug>
+#include <QtMath>
+
+#include <compositor.h>
 
 #include "../shell.h"
 #include "../compositor.h"
@@ -36,6 +41,8 @@
 #include "../shellsurface.h"
 #include "../layer.h"
 #include "../surface.h"
+#include "../imagesurface.h"
+#include "../timer.h"
 #include "desktopgrid.h"
 
 namespace Orbital {
@@ -124,6 +131,8 @@ public:
 
                 shsurf->moveViews((int)p.x(), (int)p.y());
                 shsurf->setWorkspace(wsv->workspace());
+                shsurf->storePlacement();
+                desktopgrid->invalidateSnapshot(wsv);
             } else {
                 shsurf->moveViews(origPos.x(), origPos.y());
                 shsurf->setWorkspace(shsurf->workspace());
@@ -154,6 +163,148 @@ public:
     QPointF origPos, origMousePos;
 };
 
+// A picture of a workspace at the scale of the grid, shown instead of the workspace
+// itself so that only the active one is drawn live. Opening the grid shows the picture
+// taken last, and the outdated ones are redrawn a bit later, one after the other, so
+// that the grid comes up without copying the windows of every workspace. The picture
+// is also redrawn when the workspace stops being the current one, and while the grid
+// is open at most once per interval when one of its windows commits. Until a first
+// picture is taken the workspace is shown live.
+class DesktopGrid::Snapshot
+{
+public:
+    static const int interval = 250;
+    static const int stagger = 50;
+
+    Snapshot(Compositor *c, Workspace::View *wsv, Output *out)
+        : compositor(c), workspace(wsv), output(out), surface(nullptr), view(nullptr)
+        , watcher(nullptr), dirty(true), ready(false), shown(false), scheduled(false)
+    {
+        timer.setName("desktop grid snapshot");
+        timer.setSlack(interval / 4);
+        timer.setTimeoutHandler([this]() {
+            scheduled = false;
+            refresh();
+        });
+    }
+    ~Snapshot()
+    {
+        delete watcher;
+        // the view goes away with the surface, and the workspace stops showing it
+        delete surface;
+    }
+
+    void prepare(double scale, int delay)
+    {
+        QSize size = QSize(qCeil(output->width() * scale), qCeil(output->height() * scale)).expandedTo(QSize(1, 1));
+        if (!surface || surface->size() != size) {
+            delete surface;
+            surface = new ImageSurface(compositor, size.width(), size.height());
+            surface->setOpaque(true);
+            view = new View(surface);
+            Transform tr;
+            tr.scale((double)output->width() / size.width(), (double)output->height() / size.height());
+            view->setTransform(tr);
+            dirty = true;
+            ready = false;
+        }
+        if (dirty || isStale()) {
+            schedule(delay);
+        }
+    }
+    void show(bool show)
+    {
+        shown = show;
+        workspace->setSnapshot(show && ready ? view : nullptr);
+    }
+    void schedule(int delay)
+    {
+        if (surface && !scheduled) {
+            scheduled = true;
+            timer.start(delay);
+        }
+    }
+    void invalidate()
+    {
+        dirty = true;
+        if (shown) {
+            schedule(interval);
+        }
+    }
+    // Windows that were mapped, unmapped or moved don't commit, check them by hand
+    bool isStale() const
+    {
+        std::vector<View *> views = workspace->views();
+        if (views.size() != contents.size()) {
+            return true;
+        }
+        for (size_t i = 0; i < views.size(); ++i) {
+            if (views[i] != contents[i].first || views[i]->pos() != contents[i].second) {
+                return true;
+            }
+        }
+        return false;
+    }
+    void refresh()
+    {
+        dirty = false;
+        contents.clear();
+        // drop the connections to the windows that are not in the workspace anymore
+        delete watcher;
+        watcher = new QObject;
+
+        uint32_t *data = surface ? surface->data() : nullptr;
+        if (!data) {
+            return;
+        }
+
+        int w = surface->width();
+        int h = surface->height();
+        double sx = (double)w / output->width();
+        double sy = (double)h / output->height();
+
+        pixman_image_t *dst = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8, w, h, data, surface->stride());
+        pixman_color_t black = { 0, 0, 0, 0xffff };
+        pixman_box32_t box = { 0, 0, w, h };
+        pixman_image_fill_boxes(PIXMAN_OP_SRC, dst, &black, 1, &box);
+
+        for (View *v: workspace->views()) {
+            contents.push_back({ v, v->pos() });
+
+            Surface *s = v->surface();
+            if (ShellSurface *shsurf = s->shellSurface()) {
+                QObject::connect(shsurf, &ShellSurface::contentUpdated, watcher, [this]() { invalidate(); });
+            }
+
+            QSize size = s->contentSize();
+            if (v->isMapped() && !size.isEmpty()) {
+                QRect target(qRound(v->x() * sx), qRound(v->y() * sy), qCeil(size.width() * sx), qCeil(size.height() * sy));
+                s->drawScaledContent(dst, target, PIXMAN_OP_OVER, v->alpha());
+            }
+        }
+        pixman_image_unref(dst);
+
+        surface->update(QRect(0, 0, w, h));
+        ready = true;
+        if (shown) {
+            workspace->setSnapshot(view);
+        }
+    }
+
+    Compositor *compositor;
+    Workspace::View *workspace;
+    Output *output;
+    ImageSurface *surface;
+    View *view;
+    QObject *watcher;
+    std::vector<std::pair<View *, QPointF>> contents;
+    Timer timer;
+    bool dirty;
+    bool ready;
+    bool shown;
+    bool scheduled;
+};
+
 DesktopGrid::DesktopGrid(Shell *shell)
            : Effect(shell)
            , m_shell(shell)
@@ -173,6 +324,9 @@ DesktopGrid::DesktopGrid(Shell *shell)
 
 DesktopGrid::~DesktopGrid()
 {
+    for (auto &i: m_snapshots) {
+        delete i.second;
+    }
 }
 
 void DesktopGrid::runKey(Seat *seat, uint32_t time, int key)
@@ -236,6 +390,9 @@ void DesktopGrid::run(Seat *seat)
         int margin_x = (fullSize.width() - fullRect.width()) / 2. * rx;
         int margin_y = (fullSize.height() - fullRect.height()) / 2. * rx;
 
+        m_shell->pager()->setAllVisible(out);
+        showSnapshots(out, rx);
+
         for (int i = 0; i < numWs; ++i) {
             Workspace *w = m_shell->workspaces().at(i);
             Workspace::View *wsv = workspaceViewForOutput(w, out);
@@ -264,6 +421,7 @@ void DesktopGrid::terminate(Output *out, Workspace *ws)
         ws = out->currentWorkspace();
     }
     m_activeOutputs.remove(out);
+    hideSnapshots(out);
     m_shell->pager()->activate(ws, out);
 }
 
@@ -275,6 +433,15 @@ void DesktopGrid::outputCreated(Output *o)
 void DesktopGrid::outputRemoved(Output *o)
 {
     m_activeOutputs.remove(o);
+    // the workspace views of the output may be already gone, don't touch them
+    for (auto it = m_snapshots.begin(); it != m_snapshots.end();) {
+        if (it->second->output == o) {
+            delete it->second;
+            it = m_snapshots.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 void DesktopGrid::pointerEnter(Pointer *p)
@@ -289,6 +456,61 @@ void DesktopGrid::pointerEnter(Pointer *p)
 void DesktopGrid::workspaceActivated(Workspace *ws, Output *out)
 {
     m_activeOutputs.remove(out);
+    hideSnapshots(out);
+
+    // Take the pictures of the workspaces that are not visible anymore now, rather
+    // than when the grid opens
+    for (auto &i: m_snapshots) {
+        Snapshot *snapshot = i.second;
+        if (snapshot->output == out && snapshot->workspace->workspace() != ws &&
+            (snapshot->dirty || snapshot->isStale())) {
+            snapshot->schedule(Snapshot::interval);
+        }
+    }
+}
+
+void DesktopGrid::showSnapshots(Output *out, double scale)
+{
+    if (!m_shell->compositor()->config().desktopGridSnapshots()) {
+        for (auto &i: m_snapshots) {
+            delete i.second;
+        }
+        m_snapshots.clear();
+        return;
+    }
+
+    // The current workspace is the one the user is working on, keep it live
+    int delay = 0;
+    for (Workspace *w: m_shell->workspaces()) {
+        if (w == out->currentWorkspace()) {
+            continue;
+        }
+        Workspace::View *wsv = workspaceViewForOutput(w, out);
+        Snapshot *&snapshot = m_snapshots[wsv];
+        if (!snapshot) {
+            snapshot = new Snapshot(m_shell->compositor(), wsv, out);
+        }
+        delay += Snapshot::stagger;
+        snapshot->prepare(scale, delay);
+        snapshot->show(true);
+    }
+}
+
+void DesktopGrid::hideSnapshots(Output *out)
+{
+    for (auto &i: m_snapshots) {
+        if (i.second->output == out && i.second->shown) {
+            i.second->show(false);
+        }
+    }
+}
+
+void DesktopGrid::invalidateSnapshot(Workspace::View *wsv)
+{
+    auto it = m_snapshots.find(wsv);
+    if (it != m_snapshots.end()) {
+        it->second->invalidate();
+    }
 }
 
 }
@@ -20,7 +20,10 @@
 #ifndef ORBITAL_DESKTOPGRID_H
 #define ORBITAL_DESKTOPGRID_H
 
+#include <unordered_map>
+
 #include "../effect.h"
+#include "../workspace.h"
 
 namespace Orbital {
 
@@ -38,6 +41,7 @@ public:
 
 private:
     class Grab;
+    class Snapshot;
 
     void runKey(Seat *seat, uint32_t time, int key);
     void runHotSpot(Seat *seat, uint32_t time, PointerHotSpot hs);
@@ -47,10 +51,14 @@ private:
     void outputRemoved(Output *o);
     void pointerEnter(Pointer *p);
     void workspaceActivated(Workspace *ws, Output *out);
+    void showSnapshots(Output *out, double scale);
+    void hideSnapshots(Output *out);
+    void invalidateSnapshot(Workspace::View *wsv);
 
     Shell *m_shell;
     HotSpotBinding *m_hsBinding;
     QSet<Output *> m_activeOutputs;
+    std::unordered_map<Workspace::View *, Snapshot *> m_snapshots;
 };
 
 }
@@ -0,0 +1,353 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+
+#include <wayland-server.h>
+
+#include "eventdispatcher.h"
+#include "loopmonitor.h"
+
+Q_CORE_EXPORT uint qGlobalPostedEventsCount();
+
+namespace Orbital {
+
+static uint64_t monotonicMsecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// How late a timer may fire, roughly following what QTimer documents
+static uint64_t timerSlack(Qt::TimerType type, int interval)
+{
+    switch (type) {
+        case Qt::PreciseTimer: return 0;
+        case Qt::CoarseTimer: return interval / 20;
+        case Qt::VeryCoarseTimer: return 1000;
+    }
+    return 0;
+}
+
+EventDispatcher::EventDispatcher(QObject *parent)
+               : QAbstractEventDispatcher(parent)
+               , m_loop(nullptr)
+               , m_wakeUpFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+               , m_wakeUpSource(nullptr)
+{
+    if (m_wakeUpFd < 0) {
+        qFatal("Couldn't create the event dispatcher eventfd: %s", strerror(errno));
+    }
+
+    m_timer.setName("qt timers");
+    m_timer.setRepeat(false);
+    m_timer.setTimeoutHandler([this]() { fireTimers(); });
+}
+
+EventDispatcher::~EventDispatcher()
+{
+    detach();
+    close(m_wakeUpFd);
+}
+
+EventDispatcher *EventDispatcher::instance()
+{
+    return qobject_cast<EventDispatcher *>(QAbstractEventDispatcher::instance());
+}
+
+void EventDispatcher::attach(wl_event_loop *loop)
+{
+    m_loop = loop;
+    m_wakeUpSource = wl_event_loop_add_fd(loop, m_wakeUpFd, WL_EVENT_READABLE, [](int fd, uint32_t mask, void *data) {
+        // The posted events are sent at the start of every iteration,
+        // this only needs to make the loop return from poll()
+        uint64_t count;
+        ::read(fd, &count, sizeof(count));
+        return 0;
+    }, this);
+
+    for (auto &n: m_notifiers) {
+        addNotifierSource(n.first);
+    }
+    rearmTimers();
+}
+
+void EventDispatcher::detach()
+{
+    if (!m_loop) {
+        return;
+    }
+
+    for (auto &n: m_notifiers) {
+        if (n.second) {
+            wl_event_source_remove(n.second);
+            n.second = nullptr;
+        }
+    }
+    wl_event_source_remove(m_wakeUpSource);
+    m_wakeUpSource = nullptr;
+    m_timer.stop();
+    m_loop = nullptr;
+}
+
+bool EventDispatcher::processEvents(QEventLoop::ProcessEventsFlags flags)
+{
+    m_interrupted.store(0);
+    emit awake();
+
+    LoopMonitor *monitor = LoopMonitor::instance();
+    if (!m_loop) {
+        return sendPostedEvents();
+    }
+
+    if (monitor) {
+        monitor->beginDispatch();
+    }
+    bool events = sendPostedEvents();
+    wl_event_loop_dispatch_idle(m_loop);
+    if (monitor) {
+        monitor->endDispatch();
+    }
+
+    // The posted events and the wake ups coming while waiting make the
+    // eventfd readable, so it is safe to block here until something happens
+    bool wait = (flags & QEventLoop::WaitForMoreEvents) && !events && !m_interrupted.load() &&
+                !hasDueTimers(monotonicMsecs());
+    // aboutToBlock() is used by the compositor to flush the clients, so emit it
+    // before polling even when not actually blocking
+    emit aboutToBlock();
+    pollfd pfd = { wl_event_loop_get_fd(m_loop), POLLIN, 0 };
+    if (poll(&pfd, 1, wait ? -1 : 0) < 0 && errno != EINTR) {
+        qWarning("poll failed: %s", strerror(errno));
+    }
+    if (wait) {
+        emit awake();
+    }
+
+    if (monitor) {
+        monitor->beginDispatch();
+    }
+    wl_event_loop_dispatch(m_loop, 0);
+    if (hasDueTimers(monotonicMsecs())) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Timer, "qt timers");
+        fireTimers();
+    }
+    if (monitor) {
+        monitor->endDispatch();
+    }
+    return true;
+}
+
+bool EventDispatcher::hasPendingEvents()
+{
+    return qGlobalPostedEventsCount() > 0;
+}
+
+bool EventDispatcher::sendPostedEvents()
+{
+    if (qGlobalPostedEventsCount() == 0) {
+        return false;
+    }
+
+    LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "qt posted events");
+    QCoreApplication::sendPostedEvents();
+    // The objects deleteLater()'d by the compositor's handlers, outside of any
+    // Qt event, are only deleted when explicitly asked for
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return true;
+}
+
+void EventDispatcher::registerSocketNotifier(QSocketNotifier *notifier)
+{
+    m_notifiers[notifier] = nullptr;
+    if (m_loop) {
+        addNotifierSource(notifier);
+    }
+}
+
+void EventDispatcher::unregisterSocketNotifier(QSocketNotifier *notifier)
+{
+    auto it = m_notifiers.find(notifier);
+    if (it == m_notifiers.end()) {
+        return;
+    }
+
+    if (it->second) {
+        wl_event_source_remove(it->second);
+    }
+    m_notifiers.erase(it);
+}
+
+void EventDispatcher::addNotifierSource(QSocketNotifier *notifier)
+{
+    // wayland has no equivalent of POLLPRI, so exception notifiers are only
+    // woken up by errors and hang ups
+    uint32_t mask = 0;
+    if (notifier->type() == QSocketNotifier::Read) {
+        mask = WL_EVENT_READABLE;
+    } else if (notifier->type() == QSocketNotifier::Write) {
+        mask = WL_EVENT_WRITABLE;
+    }
+
+    m_notifiers[notifier] = wl_event_loop_add_fd(m_loop, notifier->socket(), mask, [](int fd, uint32_t mask, void *data) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "qt socket notifier");
+        QEvent event(QEvent::SockAct);
+        QCoreApplication::sendEvent(static_cast<QSocketNotifier *>(data), &event);
+        return 0;
+    }, notifier);
+}
+
+void EventDispatcher::registerTimer(int timerId, int interval, Qt::TimerType timerType, QObject *object)
+{
+    m_timers.push_back({ timerId, interval, timerType, object, monotonicMsecs() + interval });
+    rearmTimers();
+}
+
+bool EventDispatcher::unregisterTimer(int timerId)
+{
+    auto it = std::find_if(m_timers.begin(), m_timers.end(), [timerId](const QtTimer &t) { return t.id == timerId; });
+    if (it == m_timers.end()) {
+        return false;
+    }
+
+    m_timers.erase(it);
+    rearmTimers();
+    return true;
+}
+
+bool EventDispatcher::unregisterTimers(QObject *object)
+{
+    auto end = std::remove_if(m_timers.begin(), m_timers.end(), [object](const QtTimer &t) { return t.object == object; });
+    if (end == m_timers.end()) {
+        return false;
+    }
+
+    m_timers.erase(end, m_timers.end());
+    rearmTimers();
+    return true;
+}
+
+QList<QAbstractEventDispatcher::TimerInfo> EventDispatcher::registeredTimers(QObject *object) const
+{
+    QList<TimerInfo> list;
+    for (const QtTimer &t: m_timers) {
+        if (t.object == object) {
+            list << TimerInfo(t.id, t.interval, t.type);
+        }
+    }
+    return list;
+}
+
+int EventDispatcher::remainingTime(int timerId)
+{
+    for (const QtTimer &t: m_timers) {
+        if (t.id == timerId) {
+            uint64_t now = monotonicMsecs();
+            return t.deadline > now ? t.deadline - now : 0;
+        }
+    }
+    return -1;
+}
+
+void EventDispatcher::wakeUp()
+{
+    uint64_t one = 1;
+    ::write(m_wakeUpFd, &one, sizeof(one));
+}
+
+void EventDispatcher::interrupt()
+{
+    m_interrupted.store(1);
+    wakeUp();
+}
+
+void EventDispatcher::flush()
+{
+}
+
+bool EventDispatcher::hasDueTimers(uint64_t now) const
+{
+    return std::any_of(m_timers.begin(), m_timers.end(), [now](const QtTimer &t) { return t.deadline <= now; });
+}
+
+void EventDispatcher::fireTimers()
+{
+    uint64_t now = monotonicMsecs();
+
+    // The timers can be (un)registered by the handlers, so collect the
+    // ids first and look them up again before sending each event
+    std::vector<int> due;
+    for (const QtTimer &t: m_timers) {
+        if (t.deadline <= now) {
+            due.push_back(t.id);
+        }
+    }
+
+    for (int id: due) {
+        auto it = std::find_if(m_timers.begin(), m_timers.end(), [id](const QtTimer &t) { return t.id == id; });
+        if (it == m_timers.end()) {
+            continue;
+        }
+
+        it->deadline += it->interval;
+        if (it->deadline <= now) {
+            it->deadline = now + it->interval;
+        }
+        QTimerEvent event(id);
+        QCoreApplication::sendEvent(it->object, &event);
+    }
+    rearmTimers();
+}
+
+void EventDispatcher::rearmTimers()
+{
+    if (!m_loop) {
+        return;
+    }
+    if (m_timers.empty()) {
+        m_timer.stop();
+        return;
+    }
+
+    // Wake up at the first deadline, but let the wheel delay it to the
+    // earliest latest time any timer may fire at, to coalesce them
+    uint64_t first = UINT64_MAX;
+    uint64_t last = UINT64_MAX;
+    for (const QtTimer &t: m_timers) {
+        first = std::min(first, t.deadline);
+        last = std::min(last, t.deadline + timerSlack(t.type, t.interval));
+    }
+
+    uint64_t now = monotonicMsecs();
+    m_timer.setSlack(last - first);
+    m_timer.start(first > now ? first - now : 1);
+}
+
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_EVENTDISPATCHER_H
+#define ORBITAL_EVENTDISPATCHER_H
+
+#include <stdint.h>
+
+#include <vector>
+#include <unordered_map>
+
+#include <QAbstractEventDispatcher>
+#include <QAtomicInt>
+
+#include "timer.h"
+
+struct wl_event_loop;
+struct wl_event_source;
+
+namespace Orbital {
+
+/**
+ * A Qt event dispatcher running on top of the wl_event_loop, so that the
+ * socket notifiers, timers and posted events of the main thread are served
+ * by the same epoll set as the compositor's sources.
+ * It must be installed before the QCoreApplication is created, and it only
+ * starts watching the Qt sources once it is attached to the compositor's
+ * event loop.
+ */
+class EventDispatcher : public QAbstractEventDispatcher
+{
+    Q_OBJECT
+public:
+    explicit EventDispatcher(QObject *parent = nullptr);
+    ~EventDispatcher();
+
+    static EventDispatcher *instance();
+
+    void attach(wl_event_loop *loop);
+    void detach();
+
+    bool processEvents(QEventLoop::ProcessEventsFlags flags) override;
+    bool hasPendingEvents() override;
+
+    void registerSocketNotifier(QSocketNotifier *notifier) override;
+    void unregisterSocketNotifier(QSocketNotifier *notifier) override;
+
+    void registerTimer(int timerId, int interval, Qt::TimerType timerType, QObject *object) override;
+    bool unregisterTimer(int timerId) override;
+    bool unregisterTimers(QObject *object) override;
+    QList<TimerInfo> registeredTimers(QObject *object) const override;
+    int remainingTime(int timerId) override;
+
+    void wakeUp() override;
+    void interrupt() override;
+    void flush() override;
+
+private:
+    struct QtTimer {
+        int id;
+        int interval;
+        Qt::TimerType type;
+        QObject *object;
+        uint64_t deadline;
+    };
+
+    bool sendPostedEvents();
+    void addNotifierSource(QSocketNotifier *notifier);
+    bool hasDueTimers(uint64_t now) const;
+    void fireTimers();
+    void rearmTimers();
+
+    wl_event_loop *m_loop;
+    int m_wakeUpFd;
+    wl_event_source *m_wakeUpSource;
+    QAtomicInt m_interrupted;
+    std::unordered_map<QSocketNotifier *, wl_event_source *> m_notifiers;
+    std::vector<QtTimer> m_timers;
+    Timer m_timer;
+};
+
+}
+
+#endif
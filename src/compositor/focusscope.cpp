@@ -96,7 +96,7 @@ void FocusScope::activate(Workspace *ws)
     Surface *surface = nullptr;
     for (Surface *s: m_activeSurfaces) {
         Debug::debug("\t{}", s);
-        if (s->workspaceMask() & ws->mask() || s->workspaceMask() == -1) {
+        if (s->workspaceMask().intersects(ws->mask())) {
             surface = s;
             break;
         }
@@ -120,12 +120,12 @@ void FocusScope::deactivateSurface()
             return;
         }
 
-        int mask = 0;
+        WorkspaceMask mask;
         for (Output *out: m_shell->compositor()->outputs()) {
             mask |= out->currentWorkspace()->mask();
         }
         for (Surface *surf: m_activeSurfaces) {
-            if (surf->workspaceMask() & mask) {
+            if (surf->workspaceMask().intersects(mask)) {
                 activate(surf);
                 break;
             }
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <QPointer>
+
+#include <compositor.h>
+
+#include "framestats.h"
+#include "shell.h"
+#include "output.h"
+#include "utils.h"
+#include "fmt/format.h"
+#include "wayland-frame-stats-server-protocol.h"
+
+namespace Orbital {
+
+const std::array<uint32_t, FrameStats::NumBuckets - 1> FrameStats::BucketBounds = {{ 4, 8, 12, 17, 20, 25, 34, 50, 67, 100, 250 }};
+
+// Frames farther apart than this many refresh cycles are the first ones after
+// an idle period, not a stall of a continuous repaint.
+static const uint32_t IdleCycles = 8;
+
+FrameStats::FrameStats()
+{
+    reset();
+}
+
+void FrameStats::frame(weston_output *output)
+{
+    timespec ts;
+    weston_compositor_read_presentation_clock(output->compositor, &ts);
+    uint64_t now = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+    m_refresh = output->current_mode ? output->current_mode->refresh : 0;
+    uint64_t period = m_refresh ? 1000000000ull / m_refresh : 16667;
+
+    if (m_lastRepaint) {
+        uint64_t interval = now - m_lastRepaint;
+        if (interval < IdleCycles * period) {
+            uint32_t ms = interval / 1000;
+            auto it = std::lower_bound(BucketBounds.begin(), BucketBounds.end(), ms);
+            m_histogram[it - BucketBounds.begin()]++;
+
+            uint32_t cycles = (interval + period / 2) / period;
+            if (cycles > 1) {
+                m_missed += cycles - 1;
+            }
+
+            // frame_time is the presentation time of the last frame, which was
+            // repainted at m_lastRepaint. It only has a millisecond resolution.
+            int32_t latency = (int32_t)(output->frame_time - (uint32_t)(m_lastRepaint / 1000));
+            if (latency >= 0) {
+                m_latencyTotal += latency * 1000;
+                m_latencyCount++;
+                m_latencyMax = std::max(m_latencyMax, (uint32_t)latency * 1000);
+            }
+        }
+    }
+    m_lastRepaint = now;
+
+    uint32_t views = 0;
+    weston_view *view;
+    wl_list_for_each(view, &output->compositor->view_list, link) {
+        if (view->output_mask & (1u << output->id)) {
+            ++views;
+        }
+    }
+    m_viewsTotal += views;
+    m_viewsMax = std::max(m_viewsMax, views);
+    ++m_frames;
+}
+
+void FrameStats::reset()
+{
+    m_frames = 0;
+    m_missed = 0;
+    m_refresh = 0;
+    m_latencyTotal = 0;
+    m_latencyCount = 0;
+    m_latencyMax = 0;
+    m_viewsTotal = 0;
+    m_viewsMax = 0;
+    m_histogram.fill(0);
+    m_lastRepaint = 0;
+    m_avoided = 0;
+}
+
+void FrameStats::dump(const char *name) const
+{
+    fmt::print(stderr, "Output '{}': {} frames, {} missed refreshes at {} mHz\n", name, m_frames, m_missed, m_refresh);
+    fmt::print(stderr, "    latency avg {} us, max {} us; views avg {}, max {}\n", latencyAvg(), m_latencyMax, viewsAvg(), m_viewsMax);
+    fmt::print(stderr, "    {} repaints avoided\n", m_avoided);
+    for (int i = 0; i < NumBuckets; ++i) {
+        if (i < NumBuckets - 1) {
+            fmt::print(stderr, "    <= {:3} ms: {}\n", BucketBounds[i], m_histogram[i]);
+        } else {
+            fmt::print(stderr, "     > {:3} ms: {}\n", BucketBounds[i - 1], m_histogram[i]);
+        }
+    }
+}
+
+
+FrameStatsManager::FrameStatsManager(Shell *shell)
+                 : Interface(shell)
+                 , RestrictedGlobal(shell->compositor(), &orbital_frame_stats_manager_interface, 2)
+{
+}
+
+FrameStatsManager::~FrameStatsManager()
+{
+}
+
+void FrameStatsManager::bind(wl_client *client, uint32_t version, uint32_t id)
+{
+    static const struct orbital_frame_stats_manager_interface implementation = {
+        wrapInterface(destroy),
+        wrapInterface(getFrameStats)
+    };
+
+    wl_resource *resource = wl_resource_create(client, &orbital_frame_stats_manager_interface, version, id);
+    wl_resource_set_implementation(resource, &implementation, this, nullptr);
+}
+
+void FrameStatsManager::destroy(wl_client *client, wl_resource *res)
+{
+    wl_resource_destroy(res);
+}
+
+void FrameStatsManager::getFrameStats(wl_client *client, wl_resource *res, uint32_t id, wl_resource *outputRes)
+{
+    class Stats
+    {
+    public:
+        Stats(Output *o)
+            : output(o)
+        {
+        }
+        void destroy(wl_client *c, wl_resource *r)
+        {
+            wl_resource_destroy(r);
+        }
+        void query(wl_client *c, wl_resource *res)
+        {
+            // The output is gone, report empty stats
+            static const FrameStats empty;
+            const FrameStats &stats = output ? output->frameStats() : empty;
+
+            orbital_frame_stats_send_stats(res, stats.frames(), stats.missedRefreshes(), stats.refresh(),
+                                           stats.latencyAvg(), stats.latencyMax(), stats.viewsAvg(), stats.viewsMax());
+
+            wl_array bounds, counts;
+            wl_array_init(&bounds);
+            wl_array_init(&counts);
+            for (uint32_t b: FrameStats::BucketBounds) {
+                *static_cast<uint32_t *>(wl_array_add(&bounds, sizeof(uint32_t))) = b;
+            }
+            for (uint32_t c: stats.histogram()) {
+                *static_cast<uint32_t *>(wl_array_add(&counts, sizeof(uint32_t))) = c;
+            }
+            orbital_frame_stats_send_histogram(res, &bounds, &counts);
+            wl_array_release(&bounds);
+            wl_array_release(&counts);
+
+            if (wl_resource_get_version(res) >= ORBITAL_FRAME_STATS_AVOIDED_REPAINTS_SINCE_VERSION) {
+                orbital_frame_stats_send_avoided_repaints(res, stats.avoidedRepaints());
+            }
+
+            orbital_frame_stats_send_done(res);
+        }
+        void reset(wl_client *c, wl_resource *res)
+        {
+            if (output) {
+                output->frameStats().reset();
+            }
+        }
+
+        QPointer<Output> output;
+    };
+
+    static const struct orbital_frame_stats_interface implementation = {
+        wrapExtInterface(&Stats::destroy),
+        wrapExtInterface(&Stats::query),
+        wrapExtInterface(&Stats::reset)
+    };
+    Stats *stats = new Stats(Output::fromResource(outputRes));
+
+    wl_resource *resource = wl_resource_create(client, &orbital_frame_stats_interface, wl_resource_get_version(res), id);
+    wl_resource_set_implementation(resource, &implementation, stats, [](wl_resource *r) {
+        delete static_cast<Stats *>(wl_resource_get_user_data(r));
+    });
+}
+
+}
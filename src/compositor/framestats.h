@@ -0,0 +1,90 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_FRAMESTATS_H
+#define ORBITAL_FRAMESTATS_H
+
+#include <stdint.h>
+
+#include <array>
+
+#include "interface.h"
+
+struct wl_resource;
+struct weston_output;
+
+namespace Orbital {
+
+class Shell;
+
+class FrameStats
+{
+public:
+    static const int NumBuckets = 12;
+    // Upper bounds in ms of the histogram buckets, the last one is unbounded
+    static const std::array<uint32_t, NumBuckets - 1> BucketBounds;
+
+    FrameStats();
+
+    void frame(weston_output *output);
+    // Counts the repaints of this output saved by scheduling them only on
+    // the outputs affected by an animation
+    void repaintAvoided() { ++m_avoided; }
+    void reset();
+    void dump(const char *name) const;
+
+    uint32_t frames() const { return m_frames; }
+    uint32_t missedRefreshes() const { return m_missed; }
+    uint32_t refresh() const { return m_refresh; }
+    uint32_t latencyAvg() const { return m_latencyCount ? m_latencyTotal / m_latencyCount : 0; }
+    uint32_t latencyMax() const { return m_latencyMax; }
+    uint32_t viewsAvg() const { return m_frames ? m_viewsTotal / m_frames : 0; }
+    uint32_t viewsMax() const { return m_viewsMax; }
+    uint32_t avoidedRepaints() const { return m_avoided; }
+    const std::array<uint32_t, NumBuckets> &histogram() const { return m_histogram; }
+
+private:
+    uint32_t m_frames;
+    uint32_t m_missed;
+    uint32_t m_refresh;
+    uint64_t m_latencyTotal;
+    uint32_t m_latencyCount;
+    uint32_t m_latencyMax;
+    uint64_t m_viewsTotal;
+    uint32_t m_viewsMax;
+    std::array<uint32_t, NumBuckets> m_histogram;
+    uint64_t m_lastRepaint;
+    uint32_t m_avoided;
+};
+
+class FrameStatsManager : public Interface, public RestrictedGlobal
+{
+public:
+    FrameStatsManager(Shell *shell);
+    ~FrameStatsManager();
+
+private:
+    void bind(wl_client *client, uint32_t version, uint32_t id) override;
+    void destroy(wl_client *client, wl_resource *resource);
+    void getFrameStats(wl_client *client, wl_resource *res, uint32_t id, wl_resource *outputRes);
+};
+
+}
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compositor.h>
+
+#include "framethrottle.h"
+#include "compositor.h"
+#include "surface.h"
+#include "view.h"
+#include "layer.h"
+
+namespace Orbital {
+
+//XXX FIXME This comes from compositor.c, it should not stay here!!
+struct weston_frame_callback {
+    struct wl_resource *resource;
+    struct wl_list link;
+};
+
+static void sendFrameCallbacks(wl_list *list, uint32_t time)
+{
+    weston_frame_callback *cb, *cnext;
+    wl_list_for_each_safe(cb, cnext, list, link) {
+        wl_callback_send_done(cb->resource, time);
+        wl_resource_destroy(cb->resource);
+    }
+}
+
+static uint32_t frameTime(weston_compositor *c)
+{
+    timespec ts;
+    weston_compositor_read_presentation_clock(c, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+FrameThrottle::Entry::Entry()
+                    : visibility(Visibility::Visible)
+{
+    wl_list_init(&held);
+}
+
+FrameThrottle::Entry::~Entry()
+{
+    // Don't leave the client waiting for the callbacks of a dead surface
+    sendFrameCallbacks(&held, 0);
+}
+
+FrameThrottle::FrameThrottle(Compositor *c)
+             : m_compositor(c)
+             , m_sessionActive(true)
+{
+    static const char *names[NumClasses] = { "frame throttle occluded", "frame throttle hidden", "frame throttle minimized" };
+    for (int i = 0; i < NumClasses; ++i) {
+        Class &cl = m_classes[i];
+        cl.rate = 0;
+        cl.count = 0;
+        cl.interval = 0;
+        cl.timer.setName(names[i]);
+        cl.timer.setTimeoutHandler([this, i]() { release((Visibility)(i + 1)); });
+    }
+}
+
+FrameThrottle::~FrameThrottle()
+{
+}
+
+void FrameThrottle::setRates(int occluded, int hidden, int minimized)
+{
+    cls(Visibility::Occluded).rate = occluded;
+    cls(Visibility::Hidden).rate = hidden;
+    cls(Visibility::Minimized).rate = minimized;
+    updateTimers();
+}
+
+void FrameThrottle::setSessionActive(bool active)
+{
+    m_sessionActive = active;
+    update();
+}
+
+void FrameThrottle::committed(Surface *surface)
+{
+    Entry *e = entry(surface);
+    if (e->visibility == Visibility::Visible) {
+        return;
+    }
+
+    // Steal the callbacks before weston moves them to the surface, where
+    // they would be sent by the next repaint of the output
+    wl_list *pending = &surface->surface()->pending.frame_callback_list;
+    wl_list_insert_list(e->held.prev, pending);
+    wl_list_init(pending);
+}
+
+void FrameThrottle::update()
+{
+    for (Class &c: m_classes) {
+        c.count = 0;
+    }
+
+    uint32_t time = 0;
+    for (auto &it: m_entries) {
+        Entry *e = it.second.get();
+        Visibility visibility = computeVisibility(it.first);
+        if (visibility != Visibility::Visible) {
+            cls(visibility).count++;
+        } else if (e->visibility != Visibility::Visible) {
+            // Let the client draw right away now that it can be seen
+            if (!time) {
+                time = frameTime(m_compositor->compositor());
+            }
+            sendFrameCallbacks(&e->held, time);
+        }
+        e->visibility = visibility;
+    }
+    updateTimers();
+}
+
+FrameThrottle::Visibility FrameThrottle::visibility(Surface *surface) const
+{
+    auto it = m_entries.find(surface);
+    return it == m_entries.end() ? Visibility::Visible : it->second->visibility;
+}
+
+FrameThrottle::Visibility FrameThrottle::computeVisibility(Surface *surface) const
+{
+    if (!m_sessionActive) {
+        return Visibility::Hidden;
+    }
+
+    const auto &views = surface->views();
+    if (views.empty()) {
+        return Visibility::Visible;
+    }
+
+    Orbital::Layer *minimizedLayer = m_compositor->layer(Compositor::Layer::Minimized);
+    bool minimized = true;
+    bool occluded = false;
+    for (View *view: views) {
+        weston_view *wv = view->m_view;
+        if (view->layer() != minimizedLayer) {
+            minimized = false;
+        }
+
+        // The views which are not in the scene were taken out of the view list
+        // by the last repaint, and the offscreen ones are on no output
+        if (wl_list_empty(&wv->link) || !wv->output_mask) {
+            continue;
+        }
+
+        // The clip is the opaque region of the views above this one, as
+        // computed by the last repaint
+        const pixman_box32_t *box = pixman_region32_extents(&wv->transform.boundingbox);
+        if (box->x1 >= box->x2 || box->y1 >= box->y2) {
+            continue;
+        }
+        if (pixman_region32_contains_rectangle(&wv->clip, const_cast<pixman_box32_t *>(box)) != PIXMAN_REGION_IN) {
+            return Visibility::Visible;
+        }
+        occluded = true;
+    }
+
+    if (minimized) {
+        return Visibility::Minimized;
+    }
+    return occluded ? Visibility::Occluded : Visibility::Hidden;
+}
+
+FrameThrottle::Entry *FrameThrottle::entry(Surface *surface)
+{
+    auto it = m_entries.find(surface);
+    if (it != m_entries.end()) {
+        return it->second.get();
+    }
+
+    QObject::connect(surface, &QObject::destroyed, m_compositor, [this, surface]() {
+        m_entries.erase(surface);
+    });
+    Entry *e = new Entry;
+    m_entries.emplace(surface, std::unique_ptr<Entry>(e));
+    return e;
+}
+
+void FrameThrottle::updateTimers()
+{
+    for (int i = 0; i < NumClasses; ++i) {
+        Class &c = m_classes[i];
+        // While the session is inactive there are no repaints at all, keep sending
+        // the callbacks of the surfaces Orbital doesn't track too
+        bool needed = c.count > 0 || (!m_sessionActive && (Visibility)(i + 1) == Visibility::Hidden);
+        int interval = needed && c.rate > 0 ? qMax(1, 1000 / c.rate) : 0;
+        if (interval == c.interval) {
+            continue;
+        }
+
+        c.interval = interval;
+        if (interval) {
+            // the exact timing doesn't matter, let the timer coalesce with others
+            c.timer.setSlack(interval / 4);
+            c.timer.start(interval);
+        } else {
+            c.timer.stop();
+        }
+    }
+}
+
+void FrameThrottle::release(Visibility visibility)
+{
+    uint32_t time = frameTime(m_compositor->compositor());
+    for (auto &it: m_entries) {
+        Entry *e = it.second.get();
+        if (e->visibility != visibility) {
+            continue;
+        }
+
+        sendFrameCallbacks(&e->held, time);
+        // The callbacks committed before the surface got hidden will not be
+        // sent by a repaint either
+        if (visibility != Visibility::Occluded) {
+            sendFrameCallbacks(&it.first->surface()->frame_callback_list, time);
+        }
+    }
+
+    if (!m_sessionActive && visibility == Visibility::Hidden) {
+        weston_view *view;
+        wl_list_for_each(view, &m_compositor->compositor()->view_list, link) {
+            sendFrameCallbacks(&view->surface->frame_callback_list, time);
+        }
+    }
+}
+
+}
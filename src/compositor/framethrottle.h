@@ -0,0 +1,95 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_FRAMETHROTTLE_H
+#define ORBITAL_FRAMETHROTTLE_H
+
+#include <memory>
+#include <unordered_map>
+
+#include <wayland-server.h>
+
+#include "timer.h"
+
+namespace Orbital {
+
+class Compositor;
+class Surface;
+
+/**
+ * Throttles the frame callbacks of the surfaces that cannot be seen.
+ * After every repaint the surfaces are classified as visible, occluded (all
+ * their views are covered by opaque views above them), hidden (not in the
+ * scene, e.g. on an inactive workspace, or offscreen) or minimized. The
+ * frame callbacks committed by a surface which is not visible are held and
+ * sent at the rate configured for its class, or when it becomes visible.
+ * While the session is inactive every surface is hidden.
+ */
+class FrameThrottle
+{
+public:
+    enum class Visibility {
+        Visible,
+        Occluded,
+        Hidden,
+        Minimized
+    };
+
+    explicit FrameThrottle(Compositor *c);
+    ~FrameThrottle();
+
+    void setRates(int occluded, int hidden, int minimized);
+    void setSessionActive(bool active);
+
+    void committed(Surface *surface);
+    void update();
+
+    Visibility visibility(Surface *surface) const;
+
+private:
+    static const int NumClasses = 3;
+    struct Entry {
+        Entry();
+        ~Entry();
+
+        Visibility visibility;
+        wl_list held;
+    };
+    struct Class {
+        Timer timer;
+        int rate;
+        int count;
+        int interval;
+    };
+
+    Visibility computeVisibility(Surface *surface) const;
+    Entry *entry(Surface *surface);
+    void updateTimers();
+    void release(Visibility visibility);
+    Class &cls(Visibility visibility) { return m_classes[(int)visibility - 1]; }
+
+    Compositor *m_compositor;
+    std::unordered_map<Surface *, std::unique_ptr<Entry>> m_entries;
+    Class m_classes[NumClasses];
+    bool m_sessionActive;
+};
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_FULLSCREENSCENE_H
+#define ORBITAL_FULLSCREENSCENE_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+namespace Orbital {
+
+/**
+ * Keeps the layers of an output that are below its fullscreen layer out of
+ * the scene while the output is covered. The output is covered as long as
+ * at least one of its workspace views shows an opaque fullscreen view, so
+ * one of them leaving fullscreen doesn't bring the layers back while another
+ * one is still fullscreen.
+ * The link function links a layer to its parent, or unlinks it.
+ */
+template<class L>
+class FullscreenScene
+{
+public:
+    explicit FullscreenScene(const std::function<void (L layer, bool linked)> &link)
+        : m_link(link)
+    {
+    }
+
+    bool isCovered() const { return !m_owners.empty(); }
+
+    // Returns true if the output was covered or uncovered by this change
+    bool setFullscreen(const void *owner, bool fullscreen)
+    {
+        bool covered = isCovered();
+        auto it = std::find(m_owners.begin(), m_owners.end(), owner);
+        if (fullscreen && it == m_owners.end()) {
+            m_owners.push_back(owner);
+        } else if (!fullscreen && it != m_owners.end()) {
+            m_owners.erase(it);
+        }
+
+        if (covered == isCovered()) {
+            return false;
+        }
+        for (const L &layer: m_layers) {
+            m_link(layer, !isCovered());
+        }
+        return true;
+    }
+
+    // Brings the layers back into the scene and forgets the fullscreen views
+    void reset()
+    {
+        if (isCovered()) {
+            m_owners.clear();
+            for (const L &layer: m_layers) {
+                m_link(layer, true);
+            }
+        }
+    }
+
+    void addLayer(const L &layer)
+    {
+        if (std::find(m_layers.begin(), m_layers.end(), layer) != m_layers.end()) {
+            return;
+        }
+        m_layers.push_back(layer);
+        if (isCovered()) {
+            m_link(layer, false);
+        }
+    }
+    void removeLayer(const L &layer)
+    {
+        auto it = std::find(m_layers.begin(), m_layers.end(), layer);
+        if (it == m_layers.end()) {
+            return;
+        }
+        m_layers.erase(it);
+        if (isCovered()) {
+            m_link(layer, true);
+        }
+    }
+
+private:
+    std::function<void (L, bool)> m_link;
+    std::vector<const void *> m_owners;
+    std::vector<L> m_layers;
+};
+
+}
+
+#endif
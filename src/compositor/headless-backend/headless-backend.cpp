@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include <compositor-headless.h>
+#include <windowed-output-api.h>
+
+#include "headless-backend.h"
+
+namespace Orbital {
+
+HeadlessBackend::HeadlessBackend()
+{
+
+}
+
+// ORBITAL_HEADLESS_OUTPUTS is a comma separated list of outputs in the
+// form WIDTHxHEIGHT[@REFRESH], e.g. "1920x1080@60,1280x720".
+bool HeadlessBackend::init(weston_compositor *c, const Config &)
+{
+    QString spec = QString::fromLocal8Bit(qgetenv("ORBITAL_HEADLESS_OUTPUTS"));
+    for (const QString &str: spec.split(QLatin1Char(','), QString::SkipEmptyParts)) {
+        QStringList parts = str.trimmed().split(QLatin1Char('@'));
+        QStringList size = parts.first().split(QLatin1Char('x'));
+
+        OutputConfig output = { 0, 0, 60 };
+        bool ok = size.count() == 2;
+        if (ok) {
+            output.width = size.at(0).toInt(&ok);
+        }
+        if (ok) {
+            output.height = size.at(1).toInt(&ok);
+        }
+        if (ok && parts.count() > 1) {
+            output.refresh = parts.at(1).toInt(&ok);
+        }
+        if (!ok || output.width <= 0 || output.height <= 0 || output.refresh <= 0) {
+            qWarning() << "Invalid headless output" << str;
+            continue;
+        }
+        m_outputs.push_back(output);
+    }
+    if (m_outputs.empty()) {
+        m_outputs.push_back({ 1024, 640, 60 });
+    }
+
+    weston_headless_backend_config config;
+    config.base.struct_version = WESTON_HEADLESS_BACKEND_CONFIG_VERSION;
+    config.base.struct_size = sizeof(config);
+    config.use_pixman = true;
+
+    if (weston_compositor_load_backend(c, WESTON_BACKEND_HEADLESS, &config.base) != 0) {
+        return false;
+    }
+
+    const struct weston_windowed_output_api *api = weston_windowed_output_get_api(c);
+    if (!api) {
+        qWarning("Cannot use weston_windowed_output_api.");
+        return false;
+    }
+
+    m_pendingListener.setNotify([this, api](Listener *, void *data) {
+        auto output = static_cast<weston_output *>(data);
+
+        size_t i = QByteArray(output->name).mid(1).toUInt() - 1;
+        const OutputConfig &cfg = m_outputs[qMin(i, m_outputs.size() - 1)];
+
+        weston_output_set_scale(output, 1);
+        weston_output_set_transform(output, WL_OUTPUT_TRANSFORM_NORMAL);
+        api->output_set_size(output, cfg.width, cfg.height);
+        // The headless backend paces its frames itself, this only changes
+        // the rate advertised to clients.
+        output->current_mode->refresh = cfg.refresh * 1000;
+        weston_output_enable(output);
+    });
+    m_pendingListener.connect(&c->output_pending_signal);
+
+    for (size_t i = 0; i < m_outputs.size(); ++i) {
+        api->output_create(c, qPrintable(QStringLiteral("H%1").arg(i + 1)));
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <QDebug>
+
+#include <compositor.h>
+#include <wayland-client.h>
+
+#include "imagesurface.h"
+#include "compositor.h"
+
+namespace Orbital {
+
+// The renderers only upload buffers that come from a client. This one lives in
+// the compositor and talks to it through a socket pair, with the client library,
+// like any other client would.
+struct InternalClient {
+    static InternalClient *get(Compositor *c);
+    void destroy();
+    void flush() { wl_display_flush(display); }
+    static void global(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+
+    wl_client *client;
+    wl_display *display;
+    wl_registry *registry;
+    wl_shm *shm;
+    wl_event_source *source;
+    wl_listener destroyListener;
+    std::vector<ImageSurface *> surfaces;
+};
+static InternalClient *s_internalClient = nullptr;
+
+void InternalClient::global(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    InternalClient *ic = static_cast<InternalClient *>(data);
+    if (!ic->shm && strcmp(interface, wl_shm_interface.name) == 0) {
+        ic->shm = static_cast<wl_shm *>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+        for (ImageSurface *s: ic->surfaces) {
+            s->createBuffer();
+        }
+        ic->flush();
+    }
+}
+
+InternalClient *InternalClient::get(Compositor *c)
+{
+    if (s_internalClient) {
+        return s_internalClient;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds) < 0) {
+        qWarning("Failed to create the internal client socket: %m");
+        return nullptr;
+    }
+    wl_client *client = wl_client_create(c->display(), fds[0]);
+    if (!client) {
+        close(fds[0]);
+        close(fds[1]);
+        return nullptr;
+    }
+    wl_display *display = wl_display_connect_to_fd(fds[1]);
+    if (!display) {
+        qWarning("Failed to connect the internal client: %m");
+        wl_client_destroy(client);
+        return nullptr;
+    }
+
+    InternalClient *ic = new InternalClient;
+    ic->client = client;
+    ic->display = display;
+    ic->shm = nullptr;
+    ic->registry = wl_display_get_registry(display);
+    static const wl_registry_listener registryListener = {
+        global,
+        [](void *, wl_registry *, uint32_t) {}
+    };
+    wl_registry_add_listener(ic->registry, &registryListener, ic);
+    ic->source = wl_event_loop_add_fd(wl_display_get_event_loop(c->display()), fds[1], WL_EVENT_READABLE,
+                                      [](int, uint32_t mask, void *data) {
+        InternalClient *ic = static_cast<InternalClient *>(data);
+        if (wl_display_dispatch(ic->display) < 0) {
+            qWarning("The internal client lost its connection: %m");
+            wl_client_destroy(ic->client);
+        } else {
+            ic->flush();
+        }
+        return 0;
+    }, ic);
+    ic->destroyListener.notify = [](wl_listener *, void *) { s_internalClient->destroy(); };
+    wl_client_add_destroy_listener(client, &ic->destroyListener);
+    ic->flush();
+
+    s_internalClient = ic;
+    return ic;
+}
+
+void InternalClient::destroy()
+{
+    // the compositor side of the buffers is gone already
+    for (ImageSurface *s: surfaces) {
+        s->releaseBuffer();
+        s->m_client = nullptr;
+    }
+    wl_event_source_remove(source);
+    if (shm) {
+        wl_shm_destroy(shm);
+    }
+    wl_registry_destroy(registry);
+    wl_display_disconnect(display);
+    delete this;
+    s_internalClient = nullptr;
+}
+
+ImageSurface::ImageSurface(Compositor *c, int w, int h)
+            : Surface(weston_surface_create(c->compositor()))
+            , m_client(nullptr)
+            , m_buffer(nullptr)
+            , m_sync(nullptr)
+            , m_data(nullptr)
+            , m_fd(-1)
+            , m_stride(w * 4)
+            , m_size(0)
+            , m_attached(false)
+{
+    setLabel("image");
+
+    weston_surface *s = surface();
+    weston_surface_set_size(s, w, h);
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    m_client = InternalClient::get(c);
+    if (!m_client) {
+        return;
+    }
+
+    m_size = m_stride * h;
+    m_fd = memfd_create("orbital-image", MFD_CLOEXEC);
+    if (m_fd < 0 || ftruncate(m_fd, m_size) < 0) {
+        qWarning("Failed to create a %dx%d image buffer: %m", w, h);
+        return;
+    }
+    void *data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        qWarning("Failed to map a %dx%d image buffer: %m", w, h);
+        return;
+    }
+    m_data = static_cast<uint32_t *>(data);
+
+    m_client->surfaces.push_back(this);
+    if (m_client->shm) {
+        createBuffer();
+        m_client->flush();
+    }
+}
+
+ImageSurface::~ImageSurface()
+{
+    if (m_client) {
+        releaseBuffer();
+        m_client->flush();
+        auto &surfaces = m_client->surfaces;
+        surfaces.erase(std::remove(surfaces.begin(), surfaces.end(), this), surfaces.end());
+    }
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void ImageSurface::createBuffer()
+{
+    wl_shm_pool *pool = wl_shm_create_pool(m_client->shm, m_fd, m_size);
+    m_buffer = wl_shm_pool_create_buffer(pool, 0, width(), height(), m_stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool);
+    close(m_fd);
+    m_fd = -1;
+
+    // The compositor side of the buffer exists once the sync is done
+    static const wl_callback_listener listener = {
+        [](void *data, wl_callback *, uint32_t) {
+            static_cast<ImageSurface *>(data)->attach();
+        }
+    };
+    m_sync = wl_display_sync(m_client->display);
+    wl_callback_add_listener(m_sync, &listener, this);
+}
+
+void ImageSurface::attach()
+{
+    wl_callback_destroy(m_sync);
+    m_sync = nullptr;
+
+    wl_resource *buffer = wl_client_get_object(m_client->client, wl_proxy_get_id(reinterpret_cast<wl_proxy *>(m_buffer)));
+    if (!buffer) {
+        return;
+    }
+    weston_buffer_reference(&surface()->buffer_ref, weston_buffer_from_resource(buffer));
+    m_attached = true;
+
+    if (!m_damage.isEmpty()) {
+        update(m_damage);
+        m_damage = QRect();
+    }
+}
+
+void ImageSurface::releaseBuffer()
+{
+    if (m_attached) {
+        weston_buffer_reference(&surface()->buffer_ref, nullptr);
+        m_attached = false;
+    }
+    if (m_sync) {
+        wl_callback_destroy(m_sync);
+        m_sync = nullptr;
+    }
+    if (m_buffer) {
+        wl_buffer_destroy(m_buffer);
+        m_buffer = nullptr;
+    }
+}
+
+void ImageSurface::setOpaque(bool opaque)
+{
+    weston_surface *s = surface();
+    pixman_region32_fini(&s->opaque);
+    pixman_region32_init_rect(&s->opaque, 0, 0, opaque ? width() : 0, opaque ? height() : 0);
+    weston_surface_damage(s);
+}
+
+void ImageSurface::update(const QRect &rect)
+{
+    if (!m_attached) {
+        m_damage |= rect;
+        return;
+    }
+
+    weston_surface *s = surface();
+    // The renderers drop their reference to shm buffers once they uploaded them,
+    // attach again so that the new damage gets uploaded too
+    s->compositor->renderer->attach(s, s->buffer_ref.buffer);
+    pixman_region32_union_rect(&s->damage, &s->damage, rect.x(), rect.y(), rect.width(), rect.height());
+    weston_surface_schedule_repaint(s);
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ORBITAL_IMAGESURFACE_H
+#define ORBITAL_IMAGESURFACE_H
+
+#include <QRect>
+
+#include "surface.h"
+
+struct wl_buffer;
+struct wl_callback;
+
+namespace Orbital {
+
+class Compositor;
+struct InternalClient;
+
+/**
+ * A surface showing pixels drawn by the compositor itself. They live in a shm
+ * buffer created by a client running inside the compositor, so that the renderer
+ * uploads them like the ones of any other client. The pixels can be drawn right
+ * away, they are shown once the compositor side of the buffer exists.
+ */
+class ImageSurface : public Surface
+{
+public:
+    ImageSurface(Compositor *c, int width, int height);
+    ~ImageSurface();
+
+    bool isValid() const { return m_data; }
+    // Premultiplied ARGB32, cleared to transparent on creation
+    uint32_t *data() const { return m_data; }
+    int stride() const { return m_stride; }
+
+    void setOpaque(bool opaque);
+    // Uploads the given area after the pixels were changed
+    void update(const QRect &rect);
+
+private:
+    void createBuffer();
+    void attach();
+    void releaseBuffer();
+
+    InternalClient *m_client;
+    wl_buffer *m_buffer;
+    wl_callback *m_sync;
+    uint32_t *m_data;
+    int m_fd;
+    int m_stride;
+    size_t m_size;
+    bool m_attached;
+    QRect m_damage;
+
+    friend InternalClient;
+};
+
+}
+
+#endif
@@ -25,6 +25,8 @@
 
 #include "layer.h"
 #include "view.h"
+#include "compositor.h"
+#include "viewindex.h"
 
 namespace Orbital {
 
@@ -95,6 +97,7 @@ Layer::~Layer()
         wl_list_init(&c->m_layer->layer.link);
     }
     if (m_layer) {
+        stackingChanged();
         wl_list_remove(&m_layer->layer.link);
     }
 }
@@ -111,6 +114,7 @@ void Layer::setParent(Layer *parent)
     if (m_parent) {
         m_parent->addChild(this);
     }
+    stackingChanged();
 }
 
 void Layer::addChild(Layer *l)
@@ -136,6 +140,7 @@ void Layer::addView(View *view)
     weston_layer_entry_insert(&m_layer->layer.view_list, &view->m_view->layer_link);
     view->m_layer = this;
     view->map();
+    view->index()->invalidate();
 }
 
 void Layer::raiseOnTop(View *view)
@@ -144,6 +149,7 @@ void Layer::raiseOnTop(View *view)
     weston_layer_entry_insert(&m_layer->layer.view_list, &view->m_view->layer_link);
     weston_view_damage_below(view->m_view);
     view->m_layer = this;
+    view->index()->invalidate();
 }
 
 void Layer::lower(View *view)
@@ -159,6 +165,19 @@ void Layer::lower(View *view)
     weston_layer_entry_insert(next, &view->m_view->layer_link);
     weston_view_damage_below(view->m_view);
     view->m_layer = this;
+    view->index()->invalidate();
+}
+
+void Layer::stackingChanged()
+{
+    if (wl_list_empty(&m_layer->layer.view_list.link)) {
+        return;
+    }
+
+    weston_view *v = wl_container_of(m_layer->layer.view_list.link.next, (weston_view *)nullptr, layer_link.link);
+    if (ViewIndex *index = Compositor::fromCompositor(v->surface->compositor)->viewIndex()) {
+        index->invalidate();
+    }
 }
 
 View *Layer::topView() const
@@ -171,6 +190,18 @@ View *Layer::topView() const
     return View::fromView(v);
 }
 
+std::vector<View *> Layer::views() const
+{
+    std::vector<View *> views;
+    weston_view *v;
+    wl_list_for_each_reverse(v, &m_layer->layer.view_list.link, layer_link.link) {
+        if (View *view = View::fromView(v)) {
+            views.push_back(view);
+        }
+    }
+    return views;
+}
+
 void Layer::setMask(int x, int y, int w, int h)
 {
     weston_layer_set_mask(&m_layer->layer, x, y, w, h);
@@ -46,6 +46,8 @@ public:
     void lower(View *view);
 
     View *topView() const;
+    // The views in the layer, from the bottom one to the top one
+    std::vector<View *> views() const;
 
     void setMask(int x, int y, int w, int h);
     void unsetMask();
@@ -59,6 +61,7 @@ public:
 
 private:
     void addChild(Layer *l);
+    void stackingChanged();
     void removeChild(Layer *l);
 
     std::unique_ptr<Wrapper> m_layer;
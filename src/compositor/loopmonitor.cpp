@@ -0,0 +1,287 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include <algorithm>
+
+#include <QDebug>
+
+#include <wayland-server.h>
+
+#include "loopmonitor.h"
+#include "shell.h"
+#include "utils.h"
+#include "fmt/format.h"
+#include "wayland-loop-monitor-server-protocol.h"
+
+namespace Orbital {
+
+static const size_t MaxLongHandlers = 64;
+
+static const char *kindName(LoopMonitor::Kind kind)
+{
+    switch (kind) {
+        case LoopMonitor::Kind::Request: return "request";
+        case LoopMonitor::Kind::Timer: return "timer";
+        case LoopMonitor::Kind::Idle: return "idle";
+        case LoopMonitor::Kind::Other: return "other";
+    }
+    return "";
+}
+
+static uint64_t now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+LoopMonitor *LoopMonitor::s_instance = nullptr;
+
+LoopMonitor::Scope::Scope(Kind kind, const char *name)
+                   : m_source(nullptr)
+{
+    LoopMonitor *m = LoopMonitor::instance();
+    if (!m) {
+        return;
+    }
+
+    m_source = m->source(kind, name, name);
+    m_start = now();
+    m->closeRequest(m_start);
+    ++m->m_depth;
+}
+
+LoopMonitor::Scope::~Scope()
+{
+    LoopMonitor *m = LoopMonitor::instance();
+    if (!m || !m_source) {
+        return;
+    }
+
+    uint64_t duration = now() - m_start;
+    if (--m->m_depth == 0) {
+        m->m_attributed += duration;
+    }
+    m->record(m_source, duration, 0);
+}
+
+LoopMonitor::LoopMonitor(wl_display *display, uint32_t threshold)
+           : m_threshold(threshold)
+           , m_request({ nullptr, 0, 0 })
+           , m_depth(0)
+           , m_dispatchStart(0)
+           , m_attributed(0)
+           , m_longHandlersPos(0)
+{
+    m_other = source(Kind::Other, nullptr, "other");
+    m_logger = wl_display_add_protocol_logger(display, [](void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *msg) {
+        if (type == WL_PROTOCOL_LOGGER_REQUEST) {
+            static_cast<LoopMonitor *>(data)->request(msg->resource, msg->message);
+        }
+    }, this);
+
+    s_instance = this;
+}
+
+LoopMonitor::~LoopMonitor()
+{
+    s_instance = nullptr;
+    wl_protocol_logger_destroy(m_logger);
+}
+
+LoopMonitor::Source *LoopMonitor::source(Kind kind, const void *key, const char *name)
+{
+    auto &source = m_sources[std::make_pair(kind, key)];
+    if (!source) {
+        source.reset(new Source{ kind, name, 0, 0, 0 });
+    }
+    return source.get();
+}
+
+// libwayland has no notification when a request handler returns, so a request is
+// considered running until the next one or until a Scope starts. The repaints,
+// the output frames and the pointer input run in a Scope of their own for this
+// reason, they would otherwise be billed to the last request before them.
+void LoopMonitor::request(wl_resource *resource, const wl_message *message)
+{
+    uint64_t time = now();
+    closeRequest(time);
+
+    auto &s = m_sources[std::make_pair(Kind::Request, (const void *)message)];
+    if (!s) {
+        s.reset(new Source{ Kind::Request, fmt::format("{}.{}", wl_resource_get_class(resource), message->name), 0, 0, 0 });
+    }
+
+    pid_t pid;
+    wl_client_get_credentials(wl_resource_get_client(resource), &pid, nullptr, nullptr);
+    m_request = { s.get(), time, pid };
+}
+
+void LoopMonitor::closeRequest(uint64_t time)
+{
+    if (!m_request.source) {
+        return;
+    }
+
+    uint64_t duration = time - m_request.start;
+    if (m_depth == 0) {
+        m_attributed += duration;
+    }
+    record(m_request.source, duration, m_request.pid);
+    m_request.source = nullptr;
+}
+
+void LoopMonitor::beginDispatch()
+{
+    m_dispatchStart = now();
+    m_attributed = 0;
+}
+
+void LoopMonitor::endDispatch()
+{
+    uint64_t time = now();
+    closeRequest(time);
+
+    uint64_t total = time - m_dispatchStart;
+    if (total > m_attributed) {
+        record(m_other, total - m_attributed, 0);
+    }
+}
+
+void LoopMonitor::record(Source *source, uint64_t duration, pid_t pid)
+{
+    source->count++;
+    source->total += duration;
+    source->max = std::max(source->max, (uint32_t)duration);
+
+    if (duration < m_threshold) {
+        return;
+    }
+
+    LongHandler handler = { now() / 1000, (uint32_t)duration, source, pid };
+    if (m_longHandlers.size() < MaxLongHandlers) {
+        m_longHandlers.push_back(handler);
+    } else {
+        m_longHandlers[m_longHandlersPos] = handler;
+    }
+    m_longHandlersPos = (m_longHandlersPos + 1) % MaxLongHandlers;
+
+    qWarning("Long %s handler '%s' took %u ms (pid %d)", kindName(source->kind), source->name.c_str(),
+             (uint32_t)(duration / 1000), pid);
+}
+
+void LoopMonitor::reset()
+{
+    for (auto &i: m_sources) {
+        Source *s = i.second.get();
+        s->count = 0;
+        s->total = 0;
+        s->max = 0;
+    }
+    m_longHandlers.clear();
+    m_longHandlersPos = 0;
+}
+
+std::vector<const LoopMonitor::Source *> LoopMonitor::sources() const
+{
+    std::vector<const Source *> sources;
+    for (auto &i: m_sources) {
+        if (i.second->count > 0) {
+            sources.push_back(i.second.get());
+        }
+    }
+    std::sort(sources.begin(), sources.end(), [](const Source *a, const Source *b) { return a->total > b->total; });
+    return sources;
+}
+
+std::vector<LoopMonitor::LongHandler> LoopMonitor::longHandlers() const
+{
+    // oldest first
+    std::vector<LongHandler> handlers;
+    size_t start = m_longHandlers.size() < MaxLongHandlers ? 0 : m_longHandlersPos;
+    for (size_t i = 0; i < m_longHandlers.size(); ++i) {
+        handlers.push_back(m_longHandlers[(start + i) % m_longHandlers.size()]);
+    }
+    return handlers;
+}
+
+void LoopMonitor::dump() const
+{
+    fmt::print(stderr, "Event loop sources:\n");
+    for (const Source *s: sources()) {
+        fmt::print(stderr, "    {:8} {:40} count {:8} total {:8} ms, avg {:6} us, max {:6} us\n", kindName(s->kind), s->name,
+                   s->count, s->total / 1000, s->total / s->count, s->max);
+    }
+    fmt::print(stderr, "Long handlers:\n");
+    for (const LongHandler &h: longHandlers()) {
+        fmt::print(stderr, "    at {} ms: {} '{}' took {} us, pid {}\n", h.time, kindName(h.source->kind), h.source->name, h.duration, h.pid);
+    }
+}
+
+
+LoopMonitorInterface::LoopMonitorInterface(Shell *shell)
+                    : Interface(shell)
+                    , RestrictedGlobal(shell->compositor(), &orbital_loop_monitor_interface, 1)
+{
+}
+
+LoopMonitorInterface::~LoopMonitorInterface()
+{
+}
+
+void LoopMonitorInterface::bind(wl_client *client, uint32_t version, uint32_t id)
+{
+    static const struct orbital_loop_monitor_interface implementation = {
+        wrapInterface(destroy),
+        wrapInterface(query),
+        wrapInterface(reset)
+    };
+
+    wl_resource *resource = wl_resource_create(client, &orbital_loop_monitor_interface, version, id);
+    wl_resource_set_implementation(resource, &implementation, this, nullptr);
+}
+
+void LoopMonitorInterface::destroy(wl_client *client, wl_resource *res)
+{
+    wl_resource_destroy(res);
+}
+
+void LoopMonitorInterface::query(wl_client *client, wl_resource *res)
+{
+    if (LoopMonitor *m = LoopMonitor::instance()) {
+        for (const LoopMonitor::Source *s: m->sources()) {
+            orbital_loop_monitor_send_source(res, (uint32_t)s->kind, s->name.c_str(), s->count, s->total / 1000, s->max);
+        }
+        for (const LoopMonitor::LongHandler &h: m->longHandlers()) {
+            orbital_loop_monitor_send_long_handler(res, h.time, h.duration, (uint32_t)h.source->kind, h.source->name.c_str(), h.pid);
+        }
+    }
+    orbital_loop_monitor_send_done(res);
+}
+
+void LoopMonitorInterface::reset(wl_client *client, wl_resource *res)
+{
+    if (LoopMonitor *m = LoopMonitor::instance()) {
+        m->reset();
+    }
+}
+
+}
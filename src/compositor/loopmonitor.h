@@ -0,0 +1,140 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_LOOPMONITOR_H
+#define ORBITAL_LOOPMONITOR_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "interface.h"
+
+struct wl_display;
+struct wl_resource;
+struct wl_message;
+struct wl_protocol_logger;
+
+namespace Orbital {
+
+class Shell;
+
+/**
+ * Measures how long the handlers dispatched by the event loop take, per
+ * source: client requests, Timers and idle callbacks. The repaints, the
+ * output frames and the pointer input are accounted in "other" buckets of
+ * their own, and the rest of the time spent in the event loop by weston and
+ * the backend in the generic "other" one. Handlers taking longer than a threshold are
+ * logged and kept in a ring buffer, along with the client that caused them.
+ */
+class LoopMonitor
+{
+public:
+    enum class Kind {
+        Request,
+        Timer,
+        Idle,
+        Other
+    };
+    struct Source {
+        Kind kind;
+        std::string name;
+        uint32_t count;
+        uint64_t total; // usecs
+        uint32_t max;
+    };
+    struct LongHandler {
+        uint64_t time; // msecs, on the monotonic clock
+        uint32_t duration; // usecs
+        const Source *source;
+        pid_t pid;
+    };
+
+    // Times the handler running in its lifetime. name must outlive the monitor.
+    class Scope
+    {
+    public:
+        Scope(Kind kind, const char *name);
+        ~Scope();
+
+    private:
+        Source *m_source;
+        uint64_t m_start;
+    };
+
+    LoopMonitor(wl_display *display, uint32_t threshold);
+    ~LoopMonitor();
+
+    static LoopMonitor *instance() { return s_instance; }
+
+    void beginDispatch();
+    void endDispatch();
+
+    void reset();
+    void dump() const;
+
+    std::vector<const Source *> sources() const;
+    std::vector<LongHandler> longHandlers() const;
+
+private:
+    struct Request {
+        Source *source;
+        uint64_t start;
+        pid_t pid;
+    };
+
+    Source *source(Kind kind, const void *key, const char *name);
+    void request(wl_resource *resource, const wl_message *message);
+    void closeRequest(uint64_t now);
+    void record(Source *source, uint64_t duration, pid_t pid);
+
+    static LoopMonitor *s_instance;
+
+    wl_protocol_logger *m_logger;
+    uint32_t m_threshold;
+    std::map<std::pair<Kind, const void *>, std::unique_ptr<Source>> m_sources;
+    Source *m_other;
+    Request m_request;
+    int m_depth;
+    uint64_t m_dispatchStart;
+    uint64_t m_attributed;
+    std::vector<LongHandler> m_longHandlers;
+    size_t m_longHandlersPos;
+};
+
+class LoopMonitorInterface : public Interface, public RestrictedGlobal
+{
+public:
+    LoopMonitorInterface(Shell *shell);
+    ~LoopMonitorInterface();
+
+private:
+    void bind(wl_client *client, uint32_t version, uint32_t id) override;
+    void destroy(wl_client *client, wl_resource *resource);
+    void query(wl_client *client, wl_resource *resource);
+    void reset(wl_client *client, wl_resource *resource);
+};
+
+}
+
+#endif
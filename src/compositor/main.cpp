@@ -24,6 +24,7 @@
 
 #include "backend.h"
 #include "compositor.h"
+#include "eventdispatcher.h"
 #include "fmt/format.h"
 
 int main(int argc, char **argv)
@@ -31,6 +32,8 @@ int main(int argc, char **argv)
     setenv("QT_MESSAGE_PATTERN", "[%{if-debug}D%{endif}%{if-warning}W%{endif}%{if-critical}C%{endif}%{if-fatal}F%{endif} %{appname}"
                                  " - %{file}:%{line}] == %{message}", 0);
 
+    // Qt must use the wl_event_loop, so install our dispatcher before it creates its own
+    QCoreApplication::setEventDispatcher(new Orbital::EventDispatcher);
     QCoreApplication app(argc, argv);
     app.setApplicationName(QStringLiteral("Orbital"));
     app.setApplicationVersion(QStringLiteral("0.1"));
@@ -72,6 +75,6 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    wl_display_run(compositor.display());
+    compositor.run();
     return 0;
 }
@@ -17,6 +17,8 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <unordered_map>
+
 #include <QDebug>
 
 #include <compositor.h>
@@ -30,9 +32,16 @@
 #include "shell.h"
 #include "pager.h"
 #include "surface.h"
+#include "viewindex.h"
+#include "animation.h"
+#include "framethrottle.h"
+#include "loopmonitor.h"
+#include "utils.h"
 
 namespace Orbital {
 
+static WrapperMap<weston_output, Output> s_outputs;
+
 struct Listener {
     wl_listener listener;
     wl_listener frameListener;
@@ -44,6 +53,17 @@ static void outputDestroyed(wl_listener *listener, void *data)
     delete reinterpret_cast<Listener *>(listener)->output;
 }
 
+// The repaints are dispatched by weston, wrap them so that the LoopMonitor
+// doesn't account them to the last client request
+static std::unordered_map<weston_output *, decltype(weston_output::repaint)> s_repaints;
+
+template<class... Args>
+static int timedRepaint(weston_output *output, Args... args)
+{
+    LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "repaint");
+    return s_repaints[output](output, args...);
+}
+
 class Root : public DummySurface
 {
 public:
@@ -74,6 +94,7 @@ Output::Output(weston_output *out)
       , m_listener(new Listener)
       , m_panelsLayer(new Layer(m_compositor->layer(Compositor::Layer::Panels)))
       , m_lockLayer(new Layer(m_compositor->layer(Compositor::Layer::Minimized)))
+      , m_rootLayer(new Layer(m_compositor->layer(Compositor::Layer::BaseBackground)))
       , m_transformRoot(new Root(m_compositor, out->width, out->height))
       , m_background(nullptr)
       , m_currentWs(nullptr)
@@ -81,27 +102,43 @@ Output::Output(weston_output *out)
       , m_lockBackgroundSurface(new LockSurface(m_compositor, out->width, out->height))
       , m_lockSurfaceView(nullptr)
       , m_locked(false)
+      , m_scene([this](Layer *layer, bool linked) { layer->setParent(linked ? m_coveredParents[layer] : nullptr); })
+      , m_availableGeometry(0, 0, out->width, out->height)
+      , m_timeline(new AnimationTimeline(this))
 {
     weston_output_init_zoom(m_output);
     m_transformRoot->view->setPos(out->x, out->y);
-    m_compositor->layer(Compositor::Layer::BaseBackground)->addView(m_transformRoot->view);
+    m_rootLayer->addView(m_transformRoot->view);
+    addCoveredLayer(m_rootLayer, m_compositor->layer(Compositor::Layer::BaseBackground));
+    addCoveredLayer(m_panelsLayer, m_compositor->layer(Compositor::Layer::Panels));
     m_lockLayer->addView(m_lockBackgroundSurface->view);
     m_lockBackgroundSurface->view->setTransformParent(m_transformRoot->view);
 
+    s_outputs.insert(out, this);
     m_listener->output = this;
     m_listener->listener.notify = outputDestroyed;
     wl_signal_add(&out->destroy_signal, &m_listener->listener);
+    s_repaints[out] = out->repaint;
+    out->repaint = timedRepaint;
     m_listener->frameListener.notify = [](wl_listener *l, void *data) {
         Listener *listener = wl_container_of(l, (Listener *)nullptr, frameListener);
         Output *o = listener->output;
-        for (auto &cb: o->m_callbacks) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "frame");
+        // weston may have rebuilt the view list while repainting
+        o->m_compositor->viewIndex()->invalidate();
+        o->m_frameStats.frame(o->m_output);
+        o->m_compositor->frameThrottle()->update();
+        // the callbacks may ask for another frame
+        std::vector<std::function<void ()>> callbacks;
+        callbacks.swap(o->m_callbacks);
+        for (auto &cb: callbacks) {
             cb();
         }
-        o->m_callbacks.clear();
     };
     wl_signal_add(&out->frame_signal, &m_listener->frameListener);
 
     connect(this, &Output::moved, this, &Output::onMoved);
+    connect(this, &Output::resized, this, &Output::onResized);
 
     if (m_compositor->shell() && m_compositor->shell()->isLocked()) {
         lock(nullptr);
@@ -118,11 +155,19 @@ Output::~Output()
     qDeleteAll(m_overlays);
     delete m_lockSurfaceView;
 
+    // the layers of other objects must not stay out of the scene
+    m_scene.reset();
+
+    s_outputs.remove(m_output);
+    m_output->repaint = s_repaints[m_output];
+    s_repaints.erase(m_output);
     wl_list_remove(&m_listener->listener.link);
     delete m_listener;
     delete m_panelsLayer;
+    delete m_rootLayer;
     delete m_lockLayer;
     delete m_transformRoot;
+    delete m_timeline;
 }
 
 Workspace *Output::currentWorkspace() const
@@ -207,17 +252,27 @@ void Output::setPanel(Surface *surface, int pos)
         ~PanelSurface()
         {
             if (pixman_region32_not_empty(&inputRegion)) {
-                emit output->availableGeometryChanged();
+                output->updateAvailableGeometry();
             }
             pixman_region32_fini(&inputRegion);
         }
         void configure(int x, int y) override
         {
             view->update();
-            if (!pixman_region32_equal(&inputRegion, &view->surface()->surface()->input)) {
-                pixman_region32_copy(&inputRegion, &view->surface()->surface()->input);
-                emit output->availableGeometryChanged();
+            // A null buffer unmaps the panel, which then doesn't take any space anymore
+            weston_surface *ws = view->surface()->surface();
+            pixman_region32_t region;
+            if (ws->buffer_ref.buffer) {
+                pixman_region32_init(&region);
+                pixman_region32_copy(&region, &ws->input);
+            } else {
+                pixman_region32_init_rect(&region, 0, 0, 0, 0);
             }
+            if (!pixman_region32_equal(&inputRegion, &region)) {
+                pixman_region32_copy(&inputRegion, &region);
+                output->updateAvailableGeometry();
+            }
+            pixman_region32_fini(&region);
         }
 
         Surface *surface;
@@ -282,6 +337,25 @@ void Output::unlock()
     repaint();
 }
 
+void Output::setFullscreen(const void *workspaceView, bool fullscreen)
+{
+    if (m_scene.setFullscreen(workspaceView, fullscreen)) {
+        weston_output_damage(m_output);
+    }
+}
+
+void Output::addCoveredLayer(Layer *layer, Layer *parent)
+{
+    m_coveredParents[layer] = parent;
+    m_scene.addLayer(layer);
+}
+
+void Output::removeCoveredLayer(Layer *layer)
+{
+    m_scene.removeLayer(layer);
+    m_coveredParents.erase(layer);
+}
+
 void Output::repaint(const std::function<void ()> &done)
 {
     weston_output_schedule_repaint(m_output);
@@ -326,12 +400,20 @@ QRect Output::geometry() const
 }
 
 QRect Output::availableGeometry() const
+{
+    return m_availableGeometry;
+}
+
+void Output::updateAvailableGeometry()
 {
     pixman_region32_t area;
     pixman_region32_init_rect(&area, 0, 0, m_output->width, m_output->height);
 
     for (View *view: m_panels) {
         weston_surface *surface = view->surface()->surface();
+        if (!surface->buffer_ref.buffer) {
+            continue;
+        }
         pixman_region32_t surf;
         pixman_region32_init(&surf);
         pixman_region32_copy(&surf, &surface->input);
@@ -340,8 +422,13 @@ QRect Output::availableGeometry() const
         pixman_region32_fini(&surf);
     }
     pixman_box32_t *box = pixman_region32_extents(&area);
+    QRect geometry(box->x1, box->y1, box->x2 - box->x1, box->y2 - box->y1);
     pixman_region32_fini(&area);
-    return QRect(box->x1, box->y1, box->x2 - box->x1, box->y2 - box->y1);
+
+    if (geometry != m_availableGeometry) {
+        m_availableGeometry = geometry;
+        emit availableGeometryChanged();
+    }
 }
 
 wl_resource *Output::resource(wl_client *client) const
@@ -383,12 +470,7 @@ void Output::setGamma(uint16_t size, uint16_t *r, uint16_t *g, uint16_t *b)
 
 Output *Output::fromOutput(weston_output *o)
 {
-    wl_listener *listener = wl_signal_get(&o->destroy_signal, outputDestroyed);
-    if (!listener) {
-        return nullptr;
-    }
-
-    return reinterpret_cast<Listener *>(listener)->output;
+    return s_outputs.find(o);
 }
 
 Output *Output::fromResource(wl_resource *res)
@@ -409,9 +491,26 @@ void Output::onMoved()
     for (View *view: m_overlays) {
         view->setPos(0, 0);
     }
+    updateAvailableGeometry();
     if (Shell *shell = m_compositor->shell()) {
         shell->pager()->updateWorkspacesPosition(this);
     }
 }
 
+void Output::onResized()
+{
+    // a mode or scale change, the dummy surfaces and everything derived from the size must follow
+    m_transformRoot->setSize(width(), height());
+    m_lockBackgroundSurface->setSize(width(), height());
+
+    updateAvailableGeometry();
+    if (Shell *shell = m_compositor->shell()) {
+        for (Workspace *ws: shell->workspaces()) {
+            workspaceViewForOutput(ws, this)->resetMask();
+        }
+        shell->pager()->updateWorkspacesPosition(this);
+    }
+    weston_output_damage(m_output);
+}
+
 }
@@ -22,10 +22,14 @@
 
 #include <functional>
 #include <vector>
+#include <unordered_map>
 
 #include <QObject>
 #include <QRect>
 
+#include "framestats.h"
+#include "fullscreenscene.h"
+
 struct wl_resource;
 struct weston_output;
 
@@ -36,7 +40,7 @@ class Workspace;
 class View;
 class Layer;
 class Root;
-class BaseAnimation;
+class AnimationTimeline;
 class Pager;
 class Surface;
 class LockSurface;
@@ -60,6 +64,12 @@ public:
 
     void lock(const std::function<void ()> &done);
     void unlock();
+    // Takes the panels and the other covered layers out of the scene while
+    // a fullscreen view of any of the workspace views covers the output
+    void setFullscreen(const void *workspaceView, bool fullscreen);
+    // A layer below the fullscreen one showing views only on this output
+    void addCoveredLayer(Layer *layer, Layer *parent);
+    void removeCoveredLayer(Layer *layer);
 
     void repaint(const std::function<void ()> &done = nullptr);
     void setPos(int x, int y);
@@ -79,24 +89,30 @@ public:
     bool contains(double x, double y) const;
     uint16_t gammaSize() const;
     void setGamma(uint16_t size, uint16_t *r, uint16_t *g, uint16_t *b);
+    FrameStats &frameStats() { return m_frameStats; }
+    AnimationTimeline *timeline() const { return m_timeline; }
 
     static Output *fromOutput(weston_output *out);
     static Output *fromResource(wl_resource *res);
 
 signals:
     void moved();
+    void resized();
     void availableGeometryChanged();
     void pointerEnter(Pointer *pointer);
     void pointerLeave(Pointer *pointer);
 
 private:
     void onMoved();
+    void onResized();
+    void updateAvailableGeometry();
 
     Compositor *m_compositor;
     weston_output *m_output;
     Listener *m_listener;
     Layer *m_panelsLayer;
     Layer *m_lockLayer;
+    Layer *m_rootLayer;
     Root *m_transformRoot;
     View *m_background;
     std::vector<View *> m_panels;
@@ -106,10 +122,14 @@ private:
     LockSurface *m_lockBackgroundSurface;
     View *m_lockSurfaceView;
     bool m_locked;
+    FullscreenScene<Layer *> m_scene;
+    std::unordered_map<Layer *, Layer *> m_coveredParents;
     std::vector<std::function<void ()>> m_callbacks;
+    QRect m_availableGeometry;
+    FrameStats m_frameStats;
+    AnimationTimeline *m_timeline;
 
     friend View;
-    friend BaseAnimation;
     friend Pager;
 };
 
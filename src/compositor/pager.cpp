@@ -38,6 +38,7 @@ public:
     Root(Output *o, Compositor *c)
         : output(o)
         , active(nullptr)
+        , allVisible(false)
     {
     }
 
@@ -47,6 +48,7 @@ public:
 
     Output *output;
     Workspace::View *active;
+    bool allVisible;
 };
 
 Pager::Pager(Compositor *c)
@@ -74,6 +76,10 @@ void Pager::addWorkspace(Workspace *ws)
             ++y;
         }
     }
+
+    for (auto &i: m_roots) {
+        updateVisibility(i.second->output);
+    }
 }
 
 void Pager::activate(Workspace *ws, Output *output)
@@ -130,17 +136,52 @@ void Pager::activate(Workspace::View *wsv, Output *output, bool animate)
     double dx = p.x();
     double dy = p.y();
 
+    root->allVisible = false;
     for (Workspace *ws: m_workspaces) {
-        Workspace::View *wsv = workspaceViewForOutput(ws, output);
+        Workspace::View *v = workspaceViewForOutput(ws, output);
+        // While switching only the workspaces already on screen and the new one
+        // need to be in the scene, the others are just moved in place.
+        bool visible = v == wsv || (animate && v->isVisible());
+        v->setVisible(visible);
+
         Transform tr;
         tr.translate(-dx, -dy);
-        wsv->setTransform(tr, animate);
+        v->setTransform(tr, animate && visible);
     }
 
     root->active = wsv;
     output->m_currentWs = wsv->workspace();
 
     m_compositor->shell()->appsFocusScope()->activate(wsv->workspace());
+    updateVisibility(output);
+}
+
+void Pager::setAllVisible(Output *output)
+{
+    Root *root = m_roots[output->id()];
+    root->allVisible = true;
+    for (Workspace *ws: m_workspaces) {
+        workspaceViewForOutput(ws, output)->setVisible(true);
+    }
+}
+
+void Pager::updateVisibility(Output *output)
+{
+    auto it = m_roots.find(output->id());
+    if (it == m_roots.end() || !it->second->active || it->second->allVisible) {
+        return;
+    }
+
+    // Wait for all the workspaces to be in place before hiding the ones off screen
+    for (Workspace *ws: m_workspaces) {
+        if (workspaceViewForOutput(ws, output)->isAnimating()) {
+            return;
+        }
+    }
+    for (Workspace *ws: m_workspaces) {
+        Workspace::View *wsv = workspaceViewForOutput(ws, output);
+        wsv->setVisible(wsv == it->second->active);
+    }
 }
 
 void Pager::updateWorkspacesPosition(Output *output)
@@ -45,6 +45,8 @@ public:
     void activatePrevWorkspace(Output *output);
     bool isWorkspaceActive(AbstractWorkspace *ws, Output *output) const;
     void updateWorkspacesPosition(Output *o);
+    void setAllVisible(Output *o);
+    void updateVisibility(Output *o);
 
 signals:
     void workspaceActivated(Workspace *ws, Output *o);
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "placementcache.h"
+
+namespace Orbital {
+
+static const uint32_t Magic = 0x4f504331; // "OPC1"
+
+struct PlacementCache::Header {
+    uint32_t magic;
+    uint32_t capacity;
+    // bumped at every access, the records keep the value of their last one
+    uint64_t clock;
+};
+
+struct PlacementCache::Record {
+    // 0 marks a free record
+    uint64_t hash;
+    uint64_t lastUsed;
+    int32_t x, y;
+    int32_t width, height;
+    int32_t workspace;
+    uint32_t reserved;
+    char output[24];
+    char key[64];
+};
+
+// FNV-1a, never 0 so that it can't be confused with a free record
+static uint64_t hashKey(const std::string &key)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c: key) {
+        hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+    }
+    return hash ? hash : 1;
+}
+
+static void copyString(char *dst, size_t size, const std::string &src)
+{
+    size_t n = std::min(src.size(), size - 1);
+    memcpy(dst, src.data(), n);
+    memset(dst + n, 0, size - n);
+}
+
+PlacementCache::PlacementCache(const QString &path, uint32_t capacity)
+              : m_path(path)
+              , m_capacity(capacity)
+              , m_opened(false)
+              , m_header(nullptr)
+              , m_records(nullptr)
+              , m_size(0)
+{
+    static_assert(sizeof(Record) == 128, "The records are stored on disk, they must keep their size");
+}
+
+PlacementCache::~PlacementCache()
+{
+    if (m_header) {
+        munmap(m_header, m_size);
+    }
+}
+
+bool PlacementCache::open()
+{
+    if (m_opened) {
+        return m_header;
+    }
+    m_opened = true;
+
+    if (m_path.isEmpty()) {
+        m_path = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/orbital/placements");
+    }
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    int fd = ::open(qPrintable(m_path), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        qWarning("Failed to open the window placement cache '%s': %m", qPrintable(m_path));
+        return false;
+    }
+
+    size_t size = sizeof(Header) + m_capacity * sizeof(Record);
+    struct stat st;
+    bool reset = fstat(fd, &st) < 0 || (size_t)st.st_size != size;
+    if (reset && (ftruncate(fd, 0) < 0 || ftruncate(fd, size) < 0)) {
+        qWarning("Failed to resize the window placement cache: %m");
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        qWarning("Failed to map the window placement cache: %m");
+        return false;
+    }
+
+    m_size = size;
+    m_header = static_cast<Header *>(data);
+    m_records = reinterpret_cast<Record *>(m_header + 1);
+    // A file of another version or capacity is thrown away, it's only a cache
+    if (reset || m_header->magic != Magic || m_header->capacity != m_capacity) {
+        memset(data, 0, size);
+        m_header->magic = Magic;
+        m_header->capacity = m_capacity;
+    }
+    for (uint32_t i = 0; i < m_capacity; ++i) {
+        const Record &r = m_records[i];
+        if (r.hash) {
+            m_index[std::string(r.key, strnlen(r.key, sizeof(r.key)))] = i;
+        }
+    }
+    return true;
+}
+
+PlacementCache::Record *PlacementCache::lookup(const std::string &key)
+{
+    auto it = m_index.find(key.substr(0, sizeof(Record::key) - 1));
+    return it == m_index.end() ? nullptr : &m_records[it->second];
+}
+
+Maybe<PlacementCache::Placement> PlacementCache::find(const std::string &key)
+{
+    if (!open()) {
+        return Maybe<Placement>();
+    }
+
+    Record *r = lookup(key);
+    if (!r) {
+        return Maybe<Placement>();
+    }
+
+    r->lastUsed = ++m_header->clock;
+    Placement p;
+    p.pos = QPoint(r->x, r->y);
+    p.size = QSize(r->width, r->height);
+    p.output = std::string(r->output, strnlen(r->output, sizeof(r->output)));
+    p.workspace = r->workspace;
+    return p;
+}
+
+void PlacementCache::store(const std::string &key, const Placement &p)
+{
+    if (!open()) {
+        return;
+    }
+
+    Record *r = lookup(key);
+    if (!r) {
+        // take a free record, or the least recently used one
+        r = &m_records[0];
+        for (uint32_t i = 0; i < m_capacity && r->hash; ++i) {
+            if (!m_records[i].hash || m_records[i].lastUsed < r->lastUsed) {
+                r = &m_records[i];
+            }
+        }
+        if (r->hash) {
+            m_index.erase(std::string(r->key, strnlen(r->key, sizeof(r->key))));
+        }
+        r->hash = hashKey(key);
+        copyString(r->key, sizeof(r->key), key);
+        m_index[r->key] = r - m_records;
+    }
+
+    r->lastUsed = ++m_header->clock;
+    r->x = p.pos.x();
+    r->y = p.pos.y();
+    r->width = p.size.width();
+    r->height = p.size.height();
+    r->workspace = p.workspace;
+    copyString(r->output, sizeof(r->output), p.output);
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ORBITAL_PLACEMENTCACHE_H
+#define ORBITAL_PLACEMENTCACHE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+
+#include <QPoint>
+#include <QSize>
+#include <QString>
+
+#include "utils.h"
+
+namespace Orbital {
+
+/**
+ * Where the windows were last placed, keyed by application. The entries are
+ * fixed size records in a small file mapped in memory, so they survive restarts
+ * and nothing is parsed when loading them. The file is only opened on first use,
+ * when the records are indexed by key, and when it is full the least recently
+ * used entry is replaced.
+ */
+class PlacementCache
+{
+public:
+    struct Placement {
+        QPoint pos;
+        QSize size;
+        std::string output;
+        int workspace;
+    };
+
+    // An empty path means the default one, in the user's cache directory
+    explicit PlacementCache(const QString &path = QString(), uint32_t capacity = 256);
+    PlacementCache(const PlacementCache &) = delete;
+    ~PlacementCache();
+
+    Maybe<Placement> find(const std::string &key);
+    void store(const std::string &key, const Placement &placement);
+
+    PlacementCache &operator=(const PlacementCache &) = delete;
+
+private:
+    struct Header;
+    struct Record;
+
+    bool open();
+    Record *lookup(const std::string &key);
+
+    QString m_path;
+    uint32_t m_capacity;
+    bool m_opened;
+    Header *m_header;
+    Record *m_records;
+    size_t m_size;
+    // the keys as stored in the records, which may be truncated
+    std::unordered_map<std::string, uint32_t> m_index;
+};
+
+}
+
+#endif
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+
+#include <QDebug>
+
+#include <wayland-server.h>
+
+#include "process.h"
+#include "timer.h"
+
+extern char **environ;
+
+namespace Orbital {
+
+static uint64_t monotonicUsecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int pidfdOpen(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// The path lookup is done before forking, the child must not allocate
+static std::string findExecutable(const std::string &program)
+{
+    if (program.find('/') != std::string::npos) {
+        return program;
+    }
+
+    const char *path = getenv("PATH");
+    std::string found;
+    StringView(path ? path : "/usr/local/bin:/usr/bin:/bin").split(':', [&](StringView dir) {
+        std::string file = dir.toStdString() + '/' + program;
+        struct stat st;
+        if (stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(file.c_str(), X_OK) == 0) {
+            found = file;
+            return true;
+        }
+        return false;
+    });
+    return found;
+}
+
+// Watches a child until it is reaped. It outlives the Process if that is
+// destroyed first, so that the child doesn't linger as a zombie.
+struct Process::Watch
+{
+    Watch(wl_event_loop *loop, pid_t p, Process *o)
+        : pid(p)
+        , owner(o)
+        , source(nullptr)
+    {
+        int fd = pidfdOpen(pid);
+        if (fd >= 0) {
+            source = wl_event_loop_add_fd(loop, fd, WL_EVENT_READABLE, [](int fd, uint32_t mask, void *data) {
+                static_cast<Watch *>(data)->check();
+                return 0;
+            }, this);
+            pidfd = fd;
+        } else {
+            // Kernels older than 5.3 have no pidfd, poll the child instead
+            pidfd = -1;
+            poll();
+        }
+    }
+    ~Watch()
+    {
+        if (source) {
+            wl_event_source_remove(source);
+        }
+        if (pidfd >= 0) {
+            close(pidfd);
+        }
+    }
+
+    void poll()
+    {
+        Timer::singleShot(500, [this]() {
+            if (!check()) {
+                poll();
+            }
+        });
+    }
+
+    // Returns true if the child was reaped, and the Watch deleted
+    bool check()
+    {
+        int status;
+        pid_t ret = waitpid(pid, &status, WNOHANG);
+        if (ret == 0 || (ret < 0 && errno == EINTR)) {
+            return false;
+        }
+        if (ret < 0) {
+            status = 0;
+        }
+
+        Process *p = owner;
+        delete this;
+        if (p) {
+            p->m_watch = nullptr;
+            p->finished(status);
+        }
+        return true;
+    }
+
+    pid_t pid;
+    Process *owner;
+    int pidfd;
+    wl_event_source *source;
+};
+
+Process::Process(wl_event_loop *loop)
+       : m_loop(loop)
+       , m_pid(0)
+       , m_watch(nullptr)
+{
+}
+
+Process::~Process()
+{
+    if (m_watch) {
+        m_watch->owner = nullptr;
+    }
+    closePassedFds();
+}
+
+void Process::setProgram(StringView program)
+{
+    m_program = program.toStdString();
+}
+
+void Process::setArguments(const std::vector<std::string> &args)
+{
+    m_arguments = args;
+}
+
+void Process::setCommand(StringView command)
+{
+    std::string cmd = command.toStdString();
+    std::vector<std::string> args;
+    std::string arg;
+    bool quoted = false;
+    bool hasArg = false;
+    for (char c: cmd) {
+        if (c == '"') {
+            quoted = !quoted;
+            hasArg = true;
+        } else if (!quoted && (c == ' ' || c == '\t')) {
+            if (hasArg) {
+                args.push_back(arg);
+                arg.clear();
+                hasArg = false;
+            }
+        } else {
+            arg += c;
+            hasArg = true;
+        }
+    }
+    if (hasArg) {
+        args.push_back(arg);
+    }
+
+    if (args.empty()) {
+        m_program.clear();
+        m_arguments.clear();
+        return;
+    }
+    m_program = args.front();
+    m_arguments.assign(args.begin() + 1, args.end());
+}
+
+void Process::setEnvironment(StringView name, StringView value)
+{
+    m_environment.push_back(name.toStdString() + '=' + value.toStdString());
+}
+
+int Process::passFd(int fd)
+{
+    // dup() doesn't carry FD_CLOEXEC over, so the copy survives the exec
+    int copy = dup(fd);
+    if (copy >= 0) {
+        m_passedFds.push_back(copy);
+    }
+    return copy;
+}
+
+void Process::setOutputFile(StringView path)
+{
+    m_outputFile = path.toStdString();
+}
+
+void Process::ignoreSignal(int signal)
+{
+    m_ignoredSignals.push_back(signal);
+}
+
+void Process::setFinishedHandler(const std::function<void (int)> &handler)
+{
+    m_finishedHandler = handler;
+}
+
+bool Process::start()
+{
+    uint64_t begin = monotonicUsecs();
+
+    std::string path = findExecutable(m_program);
+    if (path.empty()) {
+        qWarning("Cannot launch '%s': not found in PATH.", m_program.c_str());
+        closePassedFds();
+        return false;
+    }
+
+    std::vector<char *> argv;
+    argv.push_back(const_cast<char *>(m_program.c_str()));
+    for (std::string &arg: m_arguments) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    std::vector<char *> envp;
+    for (char **e = environ; *e; ++e) {
+        const char *eq = strchr(*e, '=');
+        size_t len = eq ? eq - *e + 1 : strlen(*e);
+        bool overridden = std::any_of(m_environment.begin(), m_environment.end(), [&](const std::string &v) {
+            return v.compare(0, len, *e, len) == 0;
+        });
+        if (!overridden) {
+            envp.push_back(*e);
+        }
+    }
+    for (std::string &v: m_environment) {
+        envp.push_back(const_cast<char *>(v.c_str()));
+    }
+    envp.push_back(nullptr);
+
+    int outputFd = -1;
+    if (!m_outputFile.empty()) {
+        outputFd = open(m_outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (outputFd < 0) {
+            qWarning("Cannot open '%s' for the output of '%s': %m", m_outputFile.c_str(), m_program.c_str());
+        }
+    }
+
+    // Keep the signal handlers from running in the child while it still
+    // shares the memory with the compositor
+    sigset_t all, old;
+    sigfillset(&all);
+    sigprocmask(SIG_SETMASK, &all, &old);
+
+    volatile int execErrno = 0;
+    pid_t pid = vfork();
+    if (pid == 0) {
+        setpriority(PRIO_PROCESS, 0, 0);
+
+        struct sigaction sa;
+        for (int sig = 1; sig < NSIG; ++sig) {
+            if (sigaction(sig, nullptr, &sa) == 0 && sa.sa_handler != SIG_DFL && sa.sa_handler != SIG_IGN) {
+                signal(sig, SIG_DFL);
+            }
+        }
+        for (int sig: m_ignoredSignals) {
+            signal(sig, SIG_IGN);
+        }
+        if (outputFd >= 0) {
+            dup2(outputFd, STDOUT_FILENO);
+            dup2(outputFd, STDERR_FILENO);
+        }
+
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, nullptr);
+
+        execve(path.c_str(), argv.data(), envp.data());
+        execErrno = errno;
+        _exit(127);
+    }
+    int err = pid < 0 ? errno : execErrno;
+
+    sigprocmask(SIG_SETMASK, &old, nullptr);
+    if (outputFd >= 0) {
+        close(outputFd);
+    }
+    closePassedFds();
+
+    if (pid < 0) {
+        qWarning("Cannot launch '%s': vfork failed: %s", m_program.c_str(), strerror(err));
+        return false;
+    }
+
+    m_pid = pid;
+    m_watch = new Watch(m_loop, pid, this);
+
+    if (err) {
+        // The child already exited, it will be reaped right away
+        qWarning("Cannot launch '%s': %s", m_program.c_str(), strerror(err));
+        return false;
+    }
+    qDebug("Launched '%s' (pid %d) in %llu us", m_program.c_str(), pid, (unsigned long long)(monotonicUsecs() - begin));
+    return true;
+}
+
+void Process::closePassedFds()
+{
+    for (int fd: m_passedFds) {
+        close(fd);
+    }
+    m_passedFds.clear();
+}
+
+void Process::finished(int status)
+{
+    m_pid = 0;
+    if (m_finishedHandler) {
+        m_finishedHandler(status);
+    }
+}
+
+}
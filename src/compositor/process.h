@@ -0,0 +1,85 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_PROCESS_H
+#define ORBITAL_PROCESS_H
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "stringview.h"
+
+struct wl_event_loop;
+
+namespace Orbital {
+
+/**
+ * Spawns a program with vfork() and execve(), so that the compositor's memory
+ * is never copied, and watches for its exit on the event loop through a pidfd.
+ * The child runs with the default priority and signal mask, whatever the
+ * compositor uses.
+ * Destroying the Process doesn't kill the child, it will still be reaped when
+ * it exits but the finished handler will not be called.
+ */
+class Process
+{
+public:
+    explicit Process(wl_event_loop *loop);
+    ~Process();
+
+    void setProgram(StringView program);
+    void setArguments(const std::vector<std::string> &args);
+    // Splits the command line on the spaces, except inside double quotes
+    void setCommand(StringView command);
+    void setEnvironment(StringView name, StringView value);
+    // Makes a copy of fd that the child will inherit, and returns its number
+    int passFd(int fd);
+    // Redirects both stdout and stderr to the file
+    void setOutputFile(StringView path);
+    void ignoreSignal(int signal);
+    // The handler gets the status as returned by waitpid()
+    void setFinishedHandler(const std::function<void (int status)> &handler);
+
+    bool start();
+    pid_t pid() const { return m_pid; }
+
+private:
+    struct Watch;
+
+    void closePassedFds();
+    void finished(int status);
+
+    wl_event_loop *m_loop;
+    std::string m_program;
+    std::vector<std::string> m_arguments;
+    std::vector<std::string> m_environment;
+    std::vector<int> m_passedFds;
+    std::vector<int> m_ignoredSignals;
+    std::string m_outputFile;
+    std::function<void (int)> m_finishedHandler;
+    pid_t m_pid;
+    Watch *m_watch;
+};
+
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <compositor.h>
+
+#include "screencast.h"
+#include "wayland-screenshooter-server-protocol.h"
+
+namespace Orbital {
+
+struct Screencast::Buffer {
+    wl_listener destroyListener;
+    wl_resource *resource;
+    Screencast *stream;
+    pixman_region32_t dirty;
+};
+
+Screencast::Screencast(wl_resource *resource, weston_output *output)
+          : m_resource(resource)
+          , m_output(output)
+          , m_width(output->current_mode->width)
+          , m_height(output->current_mode->height)
+          , m_pending(false)
+{
+    static const struct orbital_screencast_interface implementation = {
+        wrapInterface(destroy),
+        wrapInterface(addBuffer),
+    };
+    wl_resource_set_implementation(m_resource, &implementation, this, [](wl_resource *r) {
+        delete static_cast<Screencast *>(wl_resource_get_user_data(r));
+    });
+
+    m_frameListener.setNotify([this](Listener *, void *) { frame(); });
+    m_frameListener.connect(&output->frame_signal);
+    m_destroyListener.setNotify([this](Listener *, void *) { stop(); });
+    m_destroyListener.connect(&output->destroy_signal);
+
+    orbital_screencast_send_setup(m_resource, m_width, m_height, m_width * 4, WL_SHM_FORMAT_ARGB8888);
+}
+
+Screencast::~Screencast()
+{
+    while (!m_buffers.empty()) {
+        removeBuffer(m_buffers.back());
+    }
+}
+
+void Screencast::destroy(wl_client *client, wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+void Screencast::addBuffer(wl_client *client, wl_resource *resource, wl_resource *bufferResource)
+{
+    if (!m_output) {
+        return;
+    }
+
+    auto it = std::find_if(m_buffers.begin(), m_buffers.end(), [bufferResource](Buffer *b) { return b->resource == bufferResource; });
+    if (it != m_buffers.end()) {
+        if (std::find(m_queue.begin(), m_queue.end(), *it) == m_queue.end()) {
+            m_queue.push_back(*it);
+        }
+    } else {
+        wl_shm_buffer *shm = wl_shm_buffer_get(bufferResource);
+        uint32_t format = shm ? wl_shm_buffer_get_format(shm) : 0;
+        if (!shm || wl_shm_buffer_get_width(shm) != m_width || wl_shm_buffer_get_height(shm) != m_height ||
+            wl_shm_buffer_get_stride(shm) < m_width * 4 ||
+            (format != WL_SHM_FORMAT_ARGB8888 && format != WL_SHM_FORMAT_XRGB8888)) {
+            wl_resource_post_error(resource, ORBITAL_SCREENCAST_ERROR_BAD_BUFFER, "the buffer does not match the setup");
+            return;
+        }
+
+        Buffer *buffer = new Buffer;
+        buffer->resource = bufferResource;
+        buffer->stream = this;
+        // Nothing was copied in it yet
+        pixman_region32_init_rect(&buffer->dirty, 0, 0, m_width, m_height);
+        buffer->destroyListener.notify = [](wl_listener *l, void *) {
+            Buffer *b = wl_container_of(l, (Buffer *)nullptr, destroyListener);
+            b->stream->removeBuffer(b);
+        };
+        wl_resource_add_destroy_listener(bufferResource, &buffer->destroyListener);
+        m_buffers.push_back(buffer);
+        m_queue.push_back(buffer);
+    }
+
+    // A repaint was not streamed for the lack of a free buffer, or the next buffer
+    // is missing content that is already on screen, like a new one is
+    if (m_pending || pixman_region32_not_empty(&m_queue.front()->dirty)) {
+        m_pending = false;
+        weston_output_schedule_repaint(m_output);
+    }
+}
+
+void Screencast::removeBuffer(Buffer *buffer)
+{
+    wl_list_remove(&buffer->destroyListener.link);
+    pixman_region32_fini(&buffer->dirty);
+    m_buffers.erase(std::find(m_buffers.begin(), m_buffers.end(), buffer));
+    auto it = std::find(m_queue.begin(), m_queue.end(), buffer);
+    if (it != m_queue.end()) {
+        m_queue.erase(it);
+    }
+    delete buffer;
+}
+
+void Screencast::frame()
+{
+    if (m_output->current_mode->width != m_width || m_output->current_mode->height != m_height) {
+        stop();
+        return;
+    }
+
+    pixman_region32_t damage, transformed;
+    pixman_region32_init(&damage);
+    pixman_region32_init(&transformed);
+    pixman_region32_intersect(&damage, &m_output->region, &m_output->previous_damage);
+    pixman_region32_translate(&damage, -m_output->x, -m_output->y);
+    weston_transformed_region(m_output->width, m_output->height, m_output->transform, m_output->current_scale,
+                              &damage, &transformed);
+    pixman_region32_intersect_rect(&transformed, &transformed, 0, 0, m_width, m_height);
+
+    bool damaged = pixman_region32_not_empty(&transformed);
+    if (damaged) {
+        for (Buffer *b: m_buffers) {
+            pixman_region32_union(&b->dirty, &b->dirty, &transformed);
+        }
+    }
+    pixman_region32_fini(&damage);
+    pixman_region32_fini(&transformed);
+
+    if (m_queue.empty()) {
+        m_pending = m_pending || damaged;
+        return;
+    }
+
+    Buffer *buffer = m_queue.front();
+    if (pixman_region32_not_empty(&buffer->dirty)) {
+        m_queue.pop_front();
+        fill(buffer);
+    }
+}
+
+void Screencast::fill(Buffer *buffer)
+{
+    weston_compositor *c = m_output->compositor;
+    wl_shm_buffer *shm = wl_shm_buffer_get(buffer->resource);
+    const int stride = wl_shm_buffer_get_stride(shm);
+    const bool yflip = c->capabilities & WESTON_CAP_CAPTURE_YFLIP;
+    const bool swap = c->read_format == PIXMAN_a8b8g8r8;
+
+    int n;
+    pixman_box32_t *rects = pixman_region32_rectangles(&buffer->dirty, &n);
+
+    wl_shm_buffer_begin_access(shm);
+    uint8_t *data = static_cast<uint8_t *>(wl_shm_buffer_get_data(shm));
+    for (int i = 0; i < n; ++i) {
+        const pixman_box32_t &r = rects[i];
+        const int w = r.x2 - r.x1;
+        const int h = r.y2 - r.y1;
+        m_pixels.resize(w * h);
+        c->renderer->read_pixels(m_output, c->read_format, m_pixels.data(), r.x1, yflip ? m_height - r.y2 : r.y1, w, h);
+
+        for (int y = 0; y < h; ++y) {
+            const uint32_t *src = m_pixels.data() + (yflip ? h - 1 - y : y) * w;
+            uint32_t *dst = reinterpret_cast<uint32_t *>(data + (r.y1 + y) * stride) + r.x1;
+            if (swap) {
+                for (int x = 0; x < w; ++x) {
+                    uint32_t p = src[x];
+                    dst[x] = (p & 0xff00ff00) | ((p & 0xff) << 16) | ((p >> 16) & 0xff);
+                }
+            } else {
+                memcpy(dst, src, w * 4);
+            }
+        }
+        orbital_screencast_send_damage(m_resource, r.x1, r.y1, w, h);
+    }
+    wl_shm_buffer_end_access(shm);
+    pixman_region32_fini(&buffer->dirty);
+    pixman_region32_init(&buffer->dirty);
+
+    timespec ts;
+    weston_compositor_read_presentation_clock(c, &ts);
+    orbital_screencast_send_frame(m_resource, buffer->resource, (uint64_t)ts.tv_sec >> 32, ts.tv_sec & 0xffffffff, ts.tv_nsec);
+}
+
+void Screencast::stop()
+{
+    if (!m_output) {
+        return;
+    }
+
+    m_output = nullptr;
+    m_frameListener.disconnect();
+    m_destroyListener.disconnect();
+    orbital_screencast_send_stopped(m_resource);
+}
+
+}
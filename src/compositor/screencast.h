@@ -0,0 +1,70 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_SCREENCAST_H
+#define ORBITAL_SCREENCAST_H
+
+#include <deque>
+#include <vector>
+
+#include <wayland-server.h>
+
+#include "utils.h"
+
+struct weston_output;
+
+namespace Orbital {
+
+/**
+ * Streams the content of an output into a ring of client shm buffers.
+ * Every buffer keeps the area that changed since it was last filled, so after
+ * a repaint only that is read back from the renderer and copied in the next
+ * free buffer.
+ */
+class Screencast
+{
+public:
+    Screencast(wl_resource *resource, weston_output *output);
+    ~Screencast();
+
+private:
+    struct Buffer;
+
+    void destroy(wl_client *client, wl_resource *resource);
+    void addBuffer(wl_client *client, wl_resource *resource, wl_resource *buffer);
+    void frame();
+    void fill(Buffer *buffer);
+    void stop();
+    void removeBuffer(Buffer *buffer);
+
+    wl_resource *m_resource;
+    weston_output *m_output;
+    int m_width;
+    int m_height;
+    std::vector<Buffer *> m_buffers;
+    std::deque<Buffer *> m_queue;
+    std::vector<uint32_t> m_pixels;
+    bool m_pending;
+    Listener m_frameListener;
+    Listener m_destroyListener;
+};
+
+}
+
+#endif
@@ -27,13 +27,14 @@
 #include "seat.h"
 #include "view.h"
 #include "surface.h"
+#include "screencast.h"
 #include "wayland-screenshooter-server-protocol.h"
 
 namespace Orbital {
 
 Screenshooter::Screenshooter(Shell *s)
              : Interface(s)
-             , RestrictedGlobal(s->compositor(), &orbital_screenshooter_interface, 1)
+             , RestrictedGlobal(s->compositor(), &orbital_screenshooter_interface, 2)
              , m_compositor(s->compositor())
 {
 }
@@ -45,6 +46,7 @@ void Screenshooter::bind(wl_client *client, uint32_t version, uint32_t id)
     static const struct orbital_screenshooter_interface implementation = {
         wrapInterface(shoot),
         wrapInterface(shootSurface),
+        wrapInterface(createStream),
     };
 
     wl_resource_set_implementation(resource, &implementation, this, nullptr);
@@ -179,4 +181,17 @@ void Screenshooter::shootSurface(wl_client *client, wl_resource *resource, uint3
     grab->start(seat, PointerCursor::Kill);
 }
 
+void Screenshooter::createStream(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *outputResource)
+{
+    weston_output *output = static_cast<weston_output *>(wl_resource_get_user_data(outputResource));
+
+    wl_resource *res = wl_resource_create(client, &orbital_screencast_interface, 1, id);
+    if (!res) {
+        wl_resource_post_no_memory(resource);
+        return;
+    }
+
+    new Screencast(res, output);
+}
+
 }
@@ -38,6 +38,7 @@ private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
     void shoot(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *outputResource, wl_resource *bufferResource);
     void shootSurface(wl_client *client, wl_resource *resource, uint32_t id);
+    void createStream(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *outputResource);
 
     Compositor *m_compositor;
 };
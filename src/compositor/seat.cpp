@@ -32,6 +32,8 @@
 #include "focusscope.h"
 #include "layer.h"
 #include "surface.h"
+#include "viewindex.h"
+#include "loopmonitor.h"
 
 namespace Orbital {
 
@@ -62,6 +64,8 @@ struct Seat::Listener {
     Seat *seat;
 };
 
+static WrapperMap<weston_seat, Seat> s_seats;
+
 static void seatDestroyed(wl_listener *listener, void *data)
 {
     delete reinterpret_cast<Seat::Listener *>(listener)->seat;
@@ -78,6 +82,7 @@ Seat::Seat(Compositor *c, weston_seat *s)
     m_listener->seat = this;
     m_listener->listener.notify = seatDestroyed;
     wl_signal_add(&s->destroy_signal, &m_listener->listener);
+    s_seats.insert(s, this);
     m_listener->capsListener.notify = [](wl_listener *l, void *) {
         Listener *listener = wl_container_of(l, (Listener *)nullptr, capsListener);
         listener->seat->capsUpdated();
@@ -93,6 +98,7 @@ Seat::Seat(Compositor *c, weston_seat *s)
 
 Seat::~Seat()
 {
+    s_seats.remove(m_seat);
     wl_list_remove(&m_listener->listener.link);
     wl_list_remove(&m_listener->capsListener.link);
     wl_list_remove(&m_listener->selectionListener.link);
@@ -157,7 +163,15 @@ void Seat::sendSelection(wl_client *client)
 
 void Seat::setKeymap(const Keymap &keymap)
 {
-    Keymap km = keymap;
+    m_keymap = keymap;
+    reloadKeymap();
+}
+
+// Applies the keymap set on this seat again, with the unset values taken
+// from the current default keymap
+void Seat::reloadKeymap()
+{
+    Keymap km = m_keymap;
     km.fill(m_compositor->defaultKeymap());
 
     xkb_rule_names names = { nullptr, nullptr,
@@ -202,12 +216,7 @@ wl_client *Seat::selectionClient() const
 
 Seat *Seat::fromSeat(weston_seat *s)
 {
-    wl_listener *listener = wl_signal_get(&s->destroy_signal, seatDestroyed);
-    if (!listener) {
-        return new Seat(Compositor::fromCompositor(s->compositor), s);
-    }
-
-    return reinterpret_cast<Listener *>(listener)->seat;
+    return s_seats.find(s);
 }
 
 Seat *Seat::fromResource(wl_resource *res)
@@ -237,6 +246,9 @@ Pointer::Pointer(Seat *seat, weston_pointer *p)
 
     QObject::connect(m_seat->compositor(), &Compositor::outputRemoved, [this](Output *o) {
         m_defaultGrab.outputs.erase(o);
+        if (m_currentOutput == o) {
+            m_currentOutput = nullptr;
+        }
     });
 
     m_listener->pointer = this;
@@ -252,11 +264,23 @@ Pointer::~Pointer()
     delete m_listener;
 }
 
+// Views outside of the cell the pointer is in cannot contain it, but
+// they still need to know when the pointer left them
+void Pointer::leaveViews(const std::vector<View *> &candidates) const
+{
+    for (View *v: m_seat->compositor()->viewIndex()->hovered()) {
+        if (std::find(candidates.begin(), candidates.end(), v) == candidates.end()) {
+            v->dispatchPointerEvent(this, m_pointer->x, m_pointer->y);
+        }
+    }
+}
+
 View *Pointer::pickView(double *vx, double *vy, const std::function<bool (View *view)> &filter) const
 {
-    weston_view *view;
-    wl_list_for_each(view, &m_seat->compositor()->m_compositor->view_list, link) {
-        View *v = View::fromView(view);
+    std::vector<View *> candidates = m_seat->compositor()->viewIndex()->candidates(wl_fixed_to_int(m_pointer->x), wl_fixed_to_int(m_pointer->y));
+    leaveViews(candidates);
+
+    for (View *v: candidates) {
         if (filter && !filter(v)) {
             continue;
         }
@@ -278,9 +302,7 @@ View *Pointer::pickActivableView(double *dvx, double *dvy) const
     int ix = wl_fixed_to_int(m_pointer->x);
     int iy = wl_fixed_to_int(m_pointer->y);
 
-    weston_view *view;
-    wl_list_for_each(view, &m_seat->compositor()->m_compositor->view_list, link) {
-        View *v = View::fromView(view);
+    for (View *v: m_seat->compositor()->viewIndex()->candidates(ix, iy)) {
         Layer *l = v->layer();
         if (l && !l->acceptInput()) {
             continue;
@@ -328,7 +350,7 @@ void Pointer::updateFocus()
     View *focus = nullptr;
     weston_view *view = m_pointer->focus;
     if (view) {
-        focus = View::fromView(view);
+        focus = View::wrap(view);
     }
 
     if (focus != m_focus) {
@@ -346,10 +368,12 @@ void Pointer::move(MotionEvent evt)
 {
     double oldX = this->x();
     double oldY = this->y();
-    m_currentOutput = nullptr;
-    for (Output *o: m_seat->compositor()->outputs()) {
-        if (!m_currentOutput || o->contains(oldX, oldY)) {
-            m_currentOutput = o;
+    if (!m_currentOutput || !m_currentOutput->contains(oldX, oldY)) {
+        m_currentOutput = nullptr;
+        for (Output *o: m_seat->compositor()->outputs()) {
+            if (!m_currentOutput || o->contains(oldX, oldY)) {
+                m_currentOutput = o;
+            }
         }
     }
 
@@ -395,10 +419,10 @@ void Pointer::move(MotionEvent evt)
 
     weston_pointer_move(m_pointer, evt.m_evt);
 
-    weston_view *view;
-    wl_list_for_each(view, &m_seat->compositor()->m_compositor->view_list, link) {
-        View *v = View::fromView(view);
-        if (v && v->dispatchPointerEvent(this, m_pointer->x, m_pointer->y)) {
+    std::vector<View *> candidates = m_seat->compositor()->viewIndex()->candidates(wl_fixed_to_int(m_pointer->x), wl_fixed_to_int(m_pointer->y));
+    leaveViews(candidates);
+    for (View *v: candidates) {
+        if (v->dispatchPointerEvent(this, m_pointer->x, m_pointer->y)) {
             break;
         }
     }
@@ -605,12 +629,14 @@ void Pointer::defaultGrabFrame()
 const weston_pointer_grab_interface PointerGrab::s_grabInterface = {
     [](weston_pointer_grab *base)                                                  { fromGrab(base)->focus(); },
     [](weston_pointer_grab *base, uint32_t time, weston_pointer_motion_event *evt) {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "pointer");
         PointerGrab *grab = fromGrab(base);
         Pointer *p = grab->pointer();
         grab->motion(time, Pointer::MotionEvent(evt));
         p->handleMotionBinding(time, Pointer::MotionEvent(evt));
     },
     [](weston_pointer_grab *base, uint32_t time, uint32_t button, uint32_t state)  {
+        LoopMonitor::Scope scope(LoopMonitor::Kind::Other, "pointer");
         fromGrab(base)->button(time, rawToPointerButton(button), (Pointer::ButtonState)state);
     },
     [](weston_pointer_grab *base, uint32_t time, weston_pointer_axis_event *event) {},
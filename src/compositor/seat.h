@@ -22,12 +22,15 @@
 
 #include <functional>
 #include <unordered_set>
+#include <vector>
 
 #include <compositor.h>
 
 #include <QObject>
 #include <QPointF>
 
+#include "global.h"
+
 struct wl_resource;
 struct wl_client;
 struct weston_seat;
@@ -49,7 +52,6 @@ class ShellSurface;
 class Workspace;
 class Output;
 class FocusScope;
-class Keymap;
 enum class PointerButton : unsigned char;
 
 class Seat : public QObject
@@ -70,6 +72,7 @@ public:
     void sendSelection(wl_client *client);
 
     void setKeymap(const Keymap &keymap);
+    void reloadKeymap();
 
     wl_resource *resource(wl_client *client) const;
     weston_seat *westonSeat() const { return m_seat; }
@@ -93,6 +96,7 @@ private:
     Pointer *m_pointer;
     Keyboard *m_keyboard;
     FocusScope *m_activeScope;
+    Keymap m_keymap;
 
     friend FocusScope;
 };
@@ -183,6 +187,7 @@ public:
 
 private:
     void setFocusFixed(View *view, wl_fixed_t x, wl_fixed_t y);
+    void leaveViews(const std::vector<View *> &candidates) const;
     void handleMotionBinding(uint32_t time, MotionEvent evt);
     void updateFocus();
     struct Listener;
@@ -20,7 +20,6 @@
 #include <unistd.h>
 #include <signal.h>
 #include <linux/input.h>
-#include <sys/resource.h>
 
 #include <QDebug>
 #include <QDir>
@@ -48,6 +47,8 @@
 #include "clipboard.h"
 #include "dashboard.h"
 #include "gammacontrol.h"
+#include "framestats.h"
+#include "loopmonitor.h"
 #include "weston-desktop/wdesktop.h"
 #include "desktop-shell/desktop-shell.h"
 #include "desktop-shell/desktop-shell-workspace.h"
@@ -58,6 +59,7 @@
 #include "fmt/ostream.h"
 #include "surface.h"
 #include "desktopfile.h"
+#include "process.h"
 
 namespace Orbital {
 
@@ -80,6 +82,8 @@ Shell::Shell(Compositor *c)
     addInterface(new Screenshooter(this));
     addInterface(new ClipboardManager(this));
     addInterface(new GammaControlManager(this));
+    addInterface(new FrameStatsManager(this));
+    addInterface(new LoopMonitorInterface(this));
 
     new ZoomEffect(this);
     new DesktopGrid(this);
@@ -249,19 +253,12 @@ void Shell::autostartClients()
             continue;
         }
 
-        class Process : public QProcess
-        {
-        public:
-            Process(QObject *p) : QProcess(p) {}
-            void setupChildProcess() override { setpriority(PRIO_PROCESS, getpid(), 0); }
-        };
-
-        QProcess *proc = new Process(this);
+        Process proc(wl_display_get_event_loop(m_compositor->display()));
         QString filename = QFileInfo(QString::fromStdString(fi)).baseName();
 
-        proc->setStandardOutputFile(outputDir.filePath(filename));
-        proc->setStandardErrorFile(outputDir.filePath(filename));
-        proc->start(exec.toQString());
+        proc.setOutputFile(outputDir.filePath(filename).toLocal8Bit());
+        proc.setCommand(exec);
+        proc.start();
     }
 }
 
@@ -445,8 +442,8 @@ bool Shell::snapPos(Output *out, QPointF &p, int snapMargin) const
 void Shell::configure(ShellSurface *shsurf)
 {
     if (!shsurf->surface()->isMapped() && !shsurf->workspace()) {
-        Output *output = selectPrimaryOutput();
-        shsurf->setWorkspace(output->currentWorkspace());
+        AbstractWorkspace *ws = shsurf->restorePlacement();
+        shsurf->setWorkspace(ws ? ws : selectPrimaryOutput()->currentWorkspace());
 
         if (isSurfaceActive(shsurf)) {
             m_appsScope->activate(shsurf->surface());
@@ -494,9 +491,10 @@ void Shell::giveFocus(Seat *seat)
         }
 
         if (shsurf) {
-            for (Output *o: compositor()->outputs()) {
-                ShellView *view = shsurf->viewForOutput(o);
-                view->layer()->raiseOnTop(view);
+            for (ShellView *view: shsurf->views()) {
+                if (Layer *layer = view->layer()) {
+                    layer->raiseOnTop(view);
+                }
             }
         }
     }
@@ -519,12 +517,15 @@ void Shell::raise(Seat *seat)
     }
 
     if (shsurf) {
-        for (Output *o: compositor()->outputs()) {
-            ShellView *view = shsurf->viewForOutput(o);
-            if (view->layer()->topView() == view) {
-                view->layer()->lower(view);
+        for (ShellView *view: shsurf->views()) {
+            Layer *layer = view->layer();
+            if (!layer) {
+                continue;
+            }
+            if (layer->topView() == view) {
+                layer->lower(view);
             } else {
-                view->layer()->raiseOnTop(view);
+                layer->raiseOnTop(view);
             }
         }
     }
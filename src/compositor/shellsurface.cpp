@@ -21,6 +21,7 @@
 #include <unistd.h>
 
 #include <QDebug>
+#include <QPointer>
 
 #include <compositor.h>
 
@@ -35,11 +36,13 @@
 #include "layer.h"
 #include "fmt/format.h"
 #include "surface.h"
+#include "placementcache.h"
+#include "timer.h"
 
 namespace Orbital
 {
 
-std::unordered_map<std::string, QPoint> ShellSurface::s_posCache;
+PlacementCache ShellSurface::s_placements;
 
 ShellSurface::ShellSurface(Shell *shell, Surface *surface, Handler h)
             : Object()
@@ -63,10 +66,7 @@ ShellSurface::ShellSurface(Shell *shell, Surface *surface, Handler h)
     surface->setMoveHandler([this](Seat *seat) { move(seat); });
     surface->setShellSurface(this);
 
-    for (Output *o: shell->compositor()->outputs()) {
-        viewForOutput(o);
-    }
-    connect(shell->compositor(), &Compositor::outputCreated, this, &ShellSurface::outputCreated);
+    // The views are created lazily, only for the outputs the surface is shown on
     connect(shell->compositor(), &Compositor::outputRemoved, this, &ShellSurface::outputRemoved);
     connect(shell->pager(), &Pager::workspaceActivated, this, &ShellSurface::workspaceActivated);
 
@@ -103,8 +103,52 @@ ShellView *ShellSurface::viewForOutput(Output *o)
     return view;
 }
 
+std::vector<ShellView *> ShellSurface::views() const
+{
+    std::vector<ShellView *> views;
+    views.reserve(m_views.size());
+    for (auto &i: m_views) {
+        views.push_back(i.second);
+    }
+    return views;
+}
+
+void ShellSurface::createVisibleViews()
+{
+    for (Output *o: m_shell->compositor()->outputs()) {
+        if (m_views.count(o->id()) || !m_workspace->viewForOutput(o)->isVisible()) {
+            continue;
+        }
+
+        Maybe<QPointF> pos;
+        if (!m_views.empty()) {
+            pos = m_views.begin()->second->pos();
+        }
+        ShellView *view = viewForOutput(o);
+        if (pos) {
+            view->setInitialPos(pos.value());
+        }
+    }
+}
+
+void ShellSurface::workspaceVisibilityChanged(Output *o, bool visible)
+{
+    if (!visible || m_views.count(o->id()) || m_type == Type::None || !m_workspace) {
+        return;
+    }
+
+    m_forceMap = true;
+    committed(0, 0);
+}
+
 void ShellSurface::setWorkspace(AbstractWorkspace *ws)
 {
+    if (ws != m_workspace) {
+        disconnect(m_workspaceConnection);
+        if (Workspace *w = dynamic_cast<Workspace *>(ws)) {
+            m_workspaceConnection = connect(w, &Workspace::visibilityChanged, this, &ShellSurface::workspaceVisibilityChanged);
+        }
+    }
     m_workspace = ws;
     m_surface->setWorkspaceMask(ws->mask());
     m_forceMap = true;
@@ -182,6 +226,63 @@ void ShellSurface::setFullscreen()
     sendConfigure(rect.width(), rect.height());
 }
 
+// Pointers can send motion events much faster than the outputs refresh. The grabs
+// apply the first event right away, and then only the last one of every frame.
+class FramePacer
+{
+public:
+    FramePacer() : m_state(std::make_shared<State>()) {}
+    ~FramePacer() { m_state->pending = nullptr; }
+
+    void run(Output *output, const std::function<void ()> &func)
+    {
+        if (m_state->waiting) {
+            m_state->pending = func;
+            return;
+        }
+        func();
+        wait(m_state, output);
+    }
+    void flush()
+    {
+        if (m_state->pending) {
+            std::function<void ()> func = std::move(m_state->pending);
+            m_state->pending = nullptr;
+            func();
+        }
+    }
+
+private:
+    struct State {
+        bool waiting = false;
+        std::function<void ()> pending;
+    };
+
+    // The state outlives the pacer, which goes away with its grab, until the frame is done.
+    // The frame callbacks run while the renderer is still repainting and weston drops the
+    // repaints scheduled from there, so the pending event is applied once the loop is idle.
+    static void wait(const std::shared_ptr<State> &state, Output *output)
+    {
+        state->waiting = true;
+        output->repaint([state, output]() {
+            QPointer<Output> out(output);
+            Timer::singleShot(0, [state, out]() {
+                state->waiting = false;
+                if (state->pending) {
+                    std::function<void ()> func = std::move(state->pending);
+                    state->pending = nullptr;
+                    func();
+                    if (out) {
+                        wait(state, out);
+                    }
+                }
+            });
+        });
+    }
+
+    std::shared_ptr<State> m_state;
+};
+
 void ShellSurface::move(Seat *seat)
 {
     if (isFullscreen()) {
@@ -194,8 +295,15 @@ void ShellSurface::move(Seat *seat)
         void motion(uint32_t time, Pointer::MotionEvent evt) override
         {
             pointer()->move(evt);
-            QPointF pos = pointer()->motionToAbs(evt);
-
+            lastPos = pointer()->motionToAbs(evt);
+            if (Output *out = grabbedView->output()) {
+                pacer.run(out, [this]() { moveTo(lastPos); });
+            } else {
+                moveTo(lastPos);
+            }
+        }
+        void moveTo(const QPointF &pos)
+        {
             Output *out = grabbedView->output();
             QRect surfaceGeometry = shsurf->geometry();
 
@@ -224,13 +332,17 @@ void ShellSurface::move(Seat *seat)
         }
         void ended() override
         {
+            pacer.flush();
             shsurf->m_currentGrab = nullptr;
+            shsurf->storePlacement();
             delete this;
         }
 
         ShellSurface *shsurf;
         View *grabbedView;
         double dx, dy;
+        QPointF lastPos;
+        FramePacer pacer;
     };
 
     MoveGrab *move = new MoveGrab;
@@ -250,11 +362,24 @@ void ShellSurface::resize(Seat *seat, Edges edges)
     class ResizeGrab : public PointerGrab
     {
     public:
+        ResizeGrab()
+            : awaitingCommit(false)
+        {
+            ackTimer.setName("resize configure timeout");
+            ackTimer.setTimeoutHandler([this]() { acked(); });
+        }
         void motion(uint32_t time, Pointer::MotionEvent evt) override
         {
             pointer()->move(evt);
-            QPointF pos = pointer()->motionToAbs(evt);
-
+            lastPos = pointer()->motionToAbs(evt);
+            if (Output *out = view->output()) {
+                pacer.run(out, [this]() { resizeTo(lastPos); });
+            } else {
+                resizeTo(lastPos);
+            }
+        }
+        void resizeTo(const QPointF &pos)
+        {
             QPointF from = view->mapFromGlobal(pointer()->grabPos());
             QPointF to = view->mapFromGlobal(pos);
             QPointF d = to - from;
@@ -273,7 +398,41 @@ void ShellSurface::resize(Seat *seat, Edges edges)
                 h += d.y();
             }
 
-            shsurf->sendConfigure(w, h);
+            configure(QSize(w, h));
+        }
+        // Only one configure is in flight at a time, the next one is sent when the client
+        // commits the requested size, or gives up on it
+        void configure(const QSize &size)
+        {
+            if (awaitingCommit) {
+                next = size;
+                return;
+            }
+            if (size == requested) {
+                return;
+            }
+
+            requested = size;
+            awaitingCommit = true;
+            // don't wait forever for clients that round the size
+            ackTimer.start(200);
+            shsurf->sendConfigure(size.width(), size.height());
+        }
+        void committed()
+        {
+            if (awaitingCommit && shsurf->geometry().size() == requested) {
+                acked();
+            }
+        }
+        void acked()
+        {
+            awaitingCommit = false;
+            ackTimer.stop();
+            if (next) {
+                QSize size = next.value();
+                next.reset();
+                configure(size);
+            }
         }
         void button(uint32_t time, PointerButton button, Pointer::ButtonState state) override
         {
@@ -283,6 +442,17 @@ void ShellSurface::resize(Seat *seat, Edges edges)
         }
         void ended() override
         {
+            pacer.flush();
+            // the last size must get to the client even if it is still busy with the previous one
+            if (next && next.value() != requested) {
+                shsurf->sendConfigure(next.value().width(), next.value().height());
+                shsurf->m_placementSize = next.value();
+            } else if (awaitingCommit) {
+                shsurf->m_placementSize = requested;
+            } else {
+                shsurf->storePlacement();
+            }
+            QObject::disconnect(commitConnection);
             shsurf->m_resizeEdges = ShellSurface::Edges::None;
             shsurf->m_currentGrab = nullptr;
             delete this;
@@ -291,6 +461,13 @@ void ShellSurface::resize(Seat *seat, Edges edges)
         ShellSurface *shsurf;
         View *view;
         int32_t width, height;
+        QPointF lastPos;
+        FramePacer pacer;
+        QSize requested;
+        Maybe<QSize> next;
+        bool awaitingCommit;
+        Timer ackTimer;
+        QMetaObject::Connection commitConnection;
     };
 
     int e = (int)edges;
@@ -307,6 +484,8 @@ void ShellSurface::resize(Seat *seat, Edges edges)
     grab->height = m_height = rect.height();
     grab->shsurf = this;
     grab->view = seat->pointer()->pickView()->mainView();
+    grab->requested = rect.size();
+    grab->commitConnection = connect(this, &ShellSurface::contentUpdated, [grab]() { grab->committed(); });
 
     grab->start(seat, (PointerCursor)e);
     m_currentGrab = grab;
@@ -395,7 +574,16 @@ void ShellSurface::close()
 
 void ShellSurface::preview(Output *output)
 {
-    ShellView *v = viewForOutput(output);
+    // Only the position is needed, which is the same on all the outputs. Creating
+    // a view here would leave it unconfigured on an output the window isn't shown on.
+    auto it = m_views.find(output->id());
+    if (it == m_views.end()) {
+        it = m_views.begin();
+    }
+    if (it == m_views.end()) {
+        return;
+    }
+    ShellView *v = it->second;
 
     if (!m_previewView) {
         m_previewView = new ShellView(this);
@@ -421,12 +609,61 @@ void ShellSurface::endPreview(Output *output)
 
 void ShellSurface::moveViews(double x, double y)
 {
-    s_posCache[cacheId()] = QPoint(x, y);
     for (auto &i: m_views) {
         i.second->move(QPointF(x, y));
     }
 }
 
+void ShellSurface::storePlacement()
+{
+    m_placementSize.reset();
+    if (m_views.empty()) {
+        return;
+    }
+
+    QPointF pos = m_views.begin()->second->pos();
+    PlacementCache::Placement placement = { pos.toPoint(), geometry().size(), std::string(), -1 };
+    if (Workspace *ws = dynamic_cast<Workspace *>(m_workspace)) {
+        placement.workspace = ws->id();
+    }
+    for (Output *o: m_shell->compositor()->outputs()) {
+        if (m_shell->pager()->isWorkspaceActive(m_workspace, o)) {
+            placement.output = o->name().toStdString();
+            break;
+        }
+    }
+    // Windows with a title not seen before are placed where the last one of the app was
+    s_placements.store(cacheId(), placement);
+    if (!m_appId.empty()) {
+        s_placements.store(m_appId, placement);
+    }
+}
+
+AbstractWorkspace *ShellSurface::restorePlacement()
+{
+    Maybe<PlacementCache::Placement> cached = cachedPlacement();
+    if (m_type != Type::Toplevel || !cached) {
+        return nullptr;
+    }
+
+    const PlacementCache::Placement &placement = cached.value();
+    if (!m_toplevel.maximized && !m_toplevel.fullscreen && !placement.size.isEmpty() && placement.size != geometry().size()) {
+        sendConfigure(placement.size.width(), placement.size.height());
+    }
+
+    for (Workspace *ws: m_shell->workspaces()) {
+        if (ws->id() == placement.workspace) {
+            return ws;
+        }
+    }
+    for (Output *o: m_shell->compositor()->outputs()) {
+        if (o->name().toStdString() == placement.output) {
+            return o->currentWorkspace();
+        }
+    }
+    return nullptr;
+}
+
 void ShellSurface::setTitle(StringView t)
 {
     if (m_title != t) {
@@ -495,11 +732,13 @@ inline std::string ShellSurface::cacheId() const
     return fmt::format("{}+{}", m_appId, m_title);
 }
 
-Maybe<QPoint> ShellSurface::cachedPos() const
+Maybe<PlacementCache::Placement> ShellSurface::cachedPlacement() const
 {
-    std::string id = cacheId();
-    auto it = s_posCache.find(id);
-    return it != s_posCache.end() ? Maybe<QPoint>(it->second) : Maybe<QPoint>();
+    Maybe<PlacementCache::Placement> placement = s_placements.find(cacheId());
+    if (!placement && !m_appId.empty()) {
+        placement = s_placements.find(m_appId);
+    }
+    return placement;
 }
 
 void ShellSurface::parentSurfaceDestroyed()
@@ -551,24 +790,32 @@ void ShellSurface::committed(int x, int y)
         bool map = m_state.maximized != m_toplevel.maximized || m_state.fullscreen != m_toplevel.fullscreen ||
                    m_state.size != rect.size() || m_forceMap;
         m_forceMap = false;
+        bool resized = m_state.size != rect.size();
         m_state.size = rect.size();
         m_state.maximized = m_toplevel.maximized;
         m_state.fullscreen = m_toplevel.fullscreen;
 
+        createVisibleViews();
         for (auto &i: m_views) {
             i.second->configureToplevel(map || !i.second->layer(), m_toplevel.maximized, m_toplevel.fullscreen, dx, dy);
         }
+        // store once the client settled on a size after a resize, which may not be the last one asked
+        if (m_placementSize && (rect.size() == m_placementSize.value() || !resized)) {
+            storePlacement();
+        }
     } else if (m_type == Type::Transient) {
         if (!m_parent->shellSurface()) {
-            View *parentView = View::fromView(wl_container_of(m_parent->surface()->views.next, (weston_view *)nullptr, surface_link));
+            View *parentView = View::wrap(wl_container_of(m_parent->surface()->views.next, (weston_view *)nullptr, surface_link));
             ShellView *view = viewForOutput(parentView->output());
             view->configureTransient(parentView, m_transient.x, m_transient.y);
         } else {
+            // follow the parent on the outputs it is shown on
+            ShellSurface *parent = m_parent->shellSurface();
             for (Output *o: m_shell->compositor()->outputs()) {
-                ShellView *view = viewForOutput(o);
-                ShellView *parentView = m_parent->shellSurface()->viewForOutput(o);
-
-                view->configureTransient(parentView, m_transient.x, m_transient.y);
+                if (parent->m_views.count(o->id())) {
+                    ShellView *view = viewForOutput(o);
+                    view->configureTransient(parent->viewForOutput(o), m_transient.x, m_transient.y);
+                }
             }
         }
     }
@@ -582,6 +829,7 @@ void ShellSurface::committed(int x, int y)
     if (!wasMapped && m_surface->isMapped()) {
         emit mapped();
     }
+    emit contentUpdated();
 }
 
 void ShellSurface::updateState()
@@ -633,23 +881,14 @@ Output *ShellSurface::selectOutput()
     return output;
 }
 
-void ShellSurface::outputCreated(Output *o)
-{
-    ShellView *view = viewForOutput(o);
-
-    if (View *v = m_views.begin()->second) {
-        view->setInitialPos(v->pos());
-    }
-
-    m_forceMap = true;
-    committed(0, 0);
-}
-
 void ShellSurface::outputRemoved(Output *o)
 {
-    View *v = viewForOutput(o);
-    m_views.erase(o->id());
-    delete v;
+    auto it = m_views.find(o->id());
+    if (it != m_views.end()) {
+        View *v = it->second;
+        m_views.erase(it);
+        delete v;
+    }
 
     if (m_nextType == Type::Toplevel && m_toplevel.maximized && m_toplevel.output == o) {
         setMaximized();
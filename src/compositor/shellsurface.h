@@ -30,6 +30,7 @@
 #include "interface.h"
 #include "utils.h"
 #include "stringview.h"
+#include "placementcache.h"
 
 struct wl_client;
 struct weston_surface;
@@ -108,7 +109,10 @@ public:
     };
 
     Surface *surface() const { return m_surface; }
+    // Creates the view if the surface doesn't have one on the output yet
     ShellView *viewForOutput(Output *o);
+    // The views on the outputs the surface was shown on so far
+    std::vector<ShellView *> views() const;
     void setWorkspace(AbstractWorkspace *ws);
     Compositor *compositor() const;
     AbstractWorkspace *workspace() const;
@@ -129,6 +133,11 @@ public:
     void endPreview(Output *output);
 
     void moveViews(double x, double y);
+    // Remembers where the window is, for the next time it is mapped
+    void storePlacement();
+    // Asks for the size the window had the last time and returns the workspace
+    // it was on, or the current one of the output it was on, if they still exist
+    AbstractWorkspace *restorePlacement();
 
     void setTitle(StringView title);
     void setAppId(StringView appid);
@@ -144,7 +153,7 @@ public:
     QRect geometry() const;
     StringView title() const;
     StringView appId() const;
-    Maybe<QPoint> cachedPos() const;
+    Maybe<PlacementCache::Placement> cachedPlacement() const;
     pid_t pid() const { return m_pid; }
 
     void committed(int x, int y);
@@ -156,6 +165,7 @@ signals:
     void appIdChanged();
     void minimized();
     void restored();
+    void contentUpdated();
 
 private:
     void parentSurfaceDestroyed();
@@ -164,7 +174,8 @@ private:
     void updateState();
     void sendConfigure(int w, int h);
     Output *selectOutput();
-    void outputCreated(Output *output);
+    void createVisibleViews();
+    void workspaceVisibilityChanged(Output *output, bool visible);
     void outputRemoved(Output *output);
     void connectParent();
     void disconnectParent();
@@ -176,6 +187,7 @@ private:
     Surface *m_surface;
     Handler m_handler;
     AbstractWorkspace *m_workspace;
+    QMetaObject::Connection m_workspaceConnection;
     std::unordered_map<int, ShellView *> m_views;
     ShellView *m_previewView;
     Edges m_resizeEdges;
@@ -189,6 +201,8 @@ private:
     PointerGrab *m_currentGrab;
     bool m_isResponsive;
     bool m_minimized;
+    // the size a resize ended with, the placement is stored when the client commits it
+    Maybe<QSize> m_placementSize;
 
     Type m_type;
     Type m_nextType;
@@ -212,7 +226,7 @@ private:
         bool fullscreen;
     } m_state;
 
-    static std::unordered_map<std::string, QPoint> s_posCache;
+    static PlacementCache s_placements;
 
     friend class XWayland;
 };
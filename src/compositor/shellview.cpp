@@ -29,6 +29,7 @@
 #include "compositor.h"
 #include "dummysurface.h"
 #include "layer.h"
+#include "shell.h"
 
 namespace Orbital {
 
@@ -71,7 +72,12 @@ ShellView::ShellView(ShellSurface *surf)
          , m_blackSurface(nullptr)
          , m_animDone(nullptr)
 {
-    m_alphaAnimation.update.connect(this, &View::setAlpha);
+    m_alphaAnimation.update.connect([this](double a) {
+        setAlpha(a);
+        if (m_blackSurface && m_surface->isFullscreen() && isMapped()) {
+            updateBlackSurface();
+        }
+    });
     m_alphaAnimation.done.connect([this]() {
         if (m_animDone) {
             m_animDone();
@@ -135,8 +141,8 @@ void ShellView::configureToplevel(bool map, bool maximized, bool fullscreen, int
             } else if (!isMapped()) {
                 if (!m_initialPosSet) {
                     QPoint p(20, 100);
-                    if (Maybe<QPoint> cache = m_surface->cachedPos()) {
-                        p = cache.value();
+                    if (Maybe<PlacementCache::Placement> cache = m_surface->cachedPlacement()) {
+                        p = cache.value().pos;
                     }
                     setPos(p);
                 } else {
@@ -158,6 +164,13 @@ void ShellView::configureToplevel(bool map, bool maximized, bool fullscreen, int
         }
         setOutput(m_designedOutput);
         this->map();
+        if (m_blackSurface) {
+            // we may have left the fullscreen layer of this or another workspace
+            updateWorkspacesFullscreen();
+        }
+    }
+    if (fullscreen && isMapped()) {
+        updateBlackSurface();
     }
     update();
 }
@@ -203,6 +216,33 @@ void ShellView::cleanupAndUnmap()
         m_blackSurface->view->unmap();
     }
     unmap();
+    if (m_blackSurface) {
+        updateWorkspacesFullscreen();
+    }
+}
+
+void ShellView::updateBlackSurface()
+{
+    // A fullscreen surface as big as the output and fully opaque hides the black surface
+    // behind it, so take that out of the scene
+    const QRect rect = m_surface->geometry();
+    pixman_box32_t box = { rect.left(), rect.top(), rect.right() + 1, rect.bottom() + 1 };
+    bool covered = rect.size() == m_designedOutput->geometry().size() && alpha() == 1. &&
+                   pixman_region32_contains_rectangle(&surface()->surface()->opaque, &box) == PIXMAN_REGION_IN;
+
+    View *black = m_blackSurface->view;
+    if (covered && black->layer() == layer()) {
+        black->unmap();
+    } else if (!covered && black->layer() != layer()) {
+        workspaceViewForOutput(m_surface->workspace(), m_designedOutput)->configureFullscreen(this, black);
+    }
+}
+
+void ShellView::updateWorkspacesFullscreen()
+{
+    for (Workspace *ws: m_surface->compositor()->shell()->workspaces()) {
+        workspaceViewForOutput(ws, m_designedOutput)->updateFullscreen();
+    }
 }
 
 void ShellView::mapFullscreen()
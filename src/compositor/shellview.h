@@ -57,6 +57,8 @@ public:
 
 private:
     void mapFullscreen();
+    void updateBlackSurface();
+    void updateWorkspacesFullscreen();
 
     ShellSurface *m_surface;
     Output *m_designedOutput;
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_SPATIALGRID_H
+#define ORBITAL_SPATIALGRID_H
+
+#include <stdint.h>
+
+#include <vector>
+#include <algorithm>
+
+#include <QRect>
+
+namespace Orbital {
+
+/**
+ * A uniform grid over a rectangular area. Every cell keeps the values whose
+ * box overlaps it, sorted by their stacking order, so that a point query
+ * returns the candidates top to bottom.
+ */
+template<class T>
+class SpatialGrid
+{
+public:
+    struct Entry {
+        uint32_t order;
+        T value;
+    };
+
+    explicit SpatialGrid(int cellSize = 128)
+        : m_cellSize(cellSize)
+        , m_cols(0)
+        , m_rows(0)
+    {
+    }
+
+    void reset(const QRect &area)
+    {
+        m_area = area;
+        m_cols = area.isEmpty() ? 0 : (area.width() + m_cellSize - 1) / m_cellSize;
+        m_rows = area.isEmpty() ? 0 : (area.height() + m_cellSize - 1) / m_cellSize;
+        m_cells.clear();
+        m_cells.resize(m_cols * m_rows);
+    }
+
+    void clear()
+    {
+        for (auto &cell: m_cells) {
+            cell.clear();
+        }
+    }
+
+    const QRect &area() const { return m_area; }
+
+    void insert(const T &value, uint32_t order, const QRect &box)
+    {
+        forEachCell(box, [&](std::vector<Entry> &cell) {
+            if (cell.empty() || cell.back().order < order) {
+                cell.push_back({ order, value });
+            } else {
+                auto it = std::lower_bound(cell.begin(), cell.end(), order, [](const Entry &e, uint32_t o) { return e.order < o; });
+                cell.insert(it, { order, value });
+            }
+        });
+    }
+
+    void remove(const T &value, const QRect &box)
+    {
+        forEachCell(box, [&](std::vector<Entry> &cell) {
+            auto it = std::find_if(cell.begin(), cell.end(), [&](const Entry &e) { return e.value == value; });
+            if (it != cell.end()) {
+                cell.erase(it);
+            }
+        });
+    }
+
+    const std::vector<Entry> &at(int x, int y) const
+    {
+        static const std::vector<Entry> empty;
+        if (!m_area.contains(x, y)) {
+            return empty;
+        }
+        return m_cells[((y - m_area.y()) / m_cellSize) * m_cols + (x - m_area.x()) / m_cellSize];
+    }
+
+private:
+    template<class F>
+    void forEachCell(const QRect &box, F func)
+    {
+        QRect r = box & m_area;
+        if (r.isEmpty()) {
+            return;
+        }
+        int x1 = (r.x() - m_area.x()) / m_cellSize;
+        int y1 = (r.y() - m_area.y()) / m_cellSize;
+        int x2 = (r.right() - m_area.x()) / m_cellSize;
+        int y2 = (r.bottom() - m_area.y()) / m_cellSize;
+        for (int y = y1; y <= y2; ++y) {
+            for (int x = x1; x <= x2; ++x) {
+                func(m_cells[y * m_cols + x]);
+            }
+        }
+    }
+
+    int m_cellSize;
+    QRect m_area;
+    int m_cols;
+    int m_rows;
+    std::vector<std::vector<Entry>> m_cells;
+};
+
+}
+
+#endif
@@ -17,11 +17,15 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <vector>
+
 #include <QDebug>
 
 #include "surface.h"
 #include "view.h"
 #include "shellsurface.h"
+#include "compositor.h"
+#include "framethrottle.h"
 
 namespace Orbital {
 
@@ -43,7 +47,7 @@ Surface::Surface(weston_surface *surface, QObject *p)
        , m_roleHandler(nullptr)
        , m_listener(new Listener)
        , m_activable(true)
-       , m_workspaceMask(-1)
+       , m_workspaceMask(WorkspaceMask::all())
        , m_focusScope(nullptr)
        , m_viewCreator(nullptr)
        , m_shsurf(nullptr)
@@ -154,7 +158,7 @@ void Surface::setMoveHandler(const std::function<void (Seat *seat)> &handler)
     m_moveHandler = handler;
 }
 
-void Surface::setWorkspaceMask(int mask)
+void Surface::setWorkspaceMask(const WorkspaceMask &mask)
 {
     m_workspaceMask = mask;
 }
@@ -239,6 +243,9 @@ Surface *Surface::fromResource(wl_resource *res)
 void Surface::configure(weston_surface *s, int32_t x, int32_t y)
 {
     Surface *surf = static_cast<Surface *>(s->committed_private);
+    if (FrameThrottle *throttle = Compositor::fromCompositor(s->compositor)->frameThrottle()) {
+        throttle->committed(surf);
+    }
     if (surf->m_roleHandler) {
         surf->m_roleHandler->configure(x, y);
     }
@@ -268,6 +275,57 @@ size_t Surface::copyContent(void *data, size_t size, const QRect &rect)
     return weston_surface_copy_content(m_surface, data, size, rect.x(), rect.y(), rect.width(), rect.height());
 }
 
+bool Surface::drawScaledContent(pixman_image_t *dst, const QRect &target, pixman_op_t op, double alpha)
+{
+    QSize size = contentSize();
+    if (size.isEmpty() || target.isEmpty()) {
+        return false;
+    }
+
+    // The full resolution copy is only needed while scaling, share it between all the callers.
+    // Past a full HD window it is freed after each use instead of being kept around.
+    static const size_t maxKeptContent = 1920 * 1080;
+    static std::vector<uint32_t> content;
+    content.resize(size.width() * size.height());
+    if (copyContent(content.data(), content.size() * 4, QRect(QPoint(0, 0), size)) != 0) {
+        if (content.capacity() > maxKeptContent) {
+            std::vector<uint32_t>().swap(content);
+        }
+        return false;
+    }
+
+    double sx = (double)size.width() / target.width();
+    double sy = (double)size.height() / target.height();
+
+    pixman_image_t *src = pixman_image_create_bits_no_clear(PIXMAN_a8b8g8r8, size.width(), size.height(),
+                                                            content.data(), size.width() * 4);
+    pixman_transform_t transform;
+    pixman_transform_init_scale(&transform, pixman_double_to_fixed(sx), pixman_double_to_fixed(sy));
+    pixman_image_set_transform(src, &transform);
+    int n;
+    pixman_fixed_t *params = pixman_filter_create_separable_convolution(&n, pixman_double_to_fixed(sx), pixman_double_to_fixed(sy),
+                                                                        PIXMAN_KERNEL_BOX, PIXMAN_KERNEL_BOX,
+                                                                        PIXMAN_KERNEL_LINEAR, PIXMAN_KERNEL_LINEAR, 1, 1);
+    pixman_image_set_filter(src, PIXMAN_FILTER_SEPARABLE_CONVOLUTION, params, n);
+    free(params);
+
+    pixman_image_t *mask = nullptr;
+    if (alpha < 1.) {
+        pixman_color_t color = { 0, 0, 0, (uint16_t)(alpha * 0xffff) };
+        mask = pixman_image_create_solid_fill(&color);
+    }
+
+    pixman_image_composite32(op, src, mask, dst, 0, 0, 0, 0, target.x(), target.y(), target.width(), target.height());
+    pixman_image_unref(src);
+    if (mask) {
+        pixman_image_unref(mask);
+    }
+    if (content.capacity() > maxKeptContent) {
+        std::vector<uint32_t>().swap(content);
+    }
+    return true;
+}
+
 void Surface::setViewCreator(ViewCreator *creator)
 {
     m_viewCreator = creator;
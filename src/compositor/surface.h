@@ -29,6 +29,7 @@
 
 #include "interface.h"
 #include "stringview.h"
+#include "workspacemask.h"
 
 struct wl_resource;
 struct weston_surface;
@@ -114,6 +115,9 @@ public:
 
     QSize contentSize() const;
     size_t copyContent(void *data, size_t size, const QRect &rect);
+    // Draws the content scaled down into the target rectangle of dst, with a box
+    // filter. Returns false if the content could not be copied.
+    bool drawScaledContent(pixman_image_t *dst, const QRect &target, pixman_op_t op, double alpha = 1.);
 
     void repaint();
     void damage();
@@ -129,8 +133,8 @@ public:
     void setFocusScope(FocusScope *FocusScope);
     FocusScope *focusScope() const { return m_focusScope; }
 
-    void setWorkspaceMask(int mask);
-    int workspaceMask() const { return m_workspaceMask; }
+    void setWorkspaceMask(const WorkspaceMask &mask);
+    const WorkspaceMask &workspaceMask() const { return m_workspaceMask; }
 
     void setActivable(bool activable);
     inline bool isActivable() const { return m_activable; }
@@ -171,7 +175,7 @@ private:
     Listener *m_listener;
     bool m_activable;
     std::vector<View *> m_views;
-    int m_workspaceMask;
+    WorkspaceMask m_workspaceMask;
     std::string m_label;
     FocusScope *m_focusScope;
     ViewCreator *m_viewCreator;
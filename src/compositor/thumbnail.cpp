@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compositor.h>
+
+#include "thumbnail.h"
+#include "shellsurface.h"
+#include "surface.h"
+
+namespace Orbital {
+
+Thumbnail::Thumbnail(ShellSurface *shsurf, int interval)
+         : QObject()
+         , m_shsurf(shsurf)
+         , m_interval(interval)
+         , m_scheduled(false)
+         , m_requested(false)
+         , m_dirty(true)
+{
+    m_timer.setName("thumbnail refresh");
+    m_timer.setSlack(interval / 4);
+    m_timer.setTimeoutHandler([this]() {
+        m_scheduled = false;
+        refresh();
+    });
+    connect(shsurf, &ShellSurface::contentUpdated, this, &Thumbnail::committed);
+}
+
+void Thumbnail::request(const QSize &maxSize)
+{
+    m_requested = true;
+    if (maxSize != m_maxSize || m_image.isNull()) {
+        m_maxSize = maxSize;
+        refresh();
+    } else if (m_dirty) {
+        committed();
+    }
+}
+
+void Thumbnail::cancel()
+{
+    m_requested = false;
+    if (m_scheduled) {
+        m_scheduled = false;
+        m_timer.stop();
+    }
+}
+
+void Thumbnail::committed()
+{
+    m_dirty = true;
+    if (m_requested && !m_scheduled) {
+        m_scheduled = true;
+        m_timer.start(m_interval);
+    }
+}
+
+// A failed refresh leaves the request pending, for the next commit
+void Thumbnail::refresh()
+{
+    if (m_scheduled) {
+        m_scheduled = false;
+        m_timer.stop();
+    }
+    Surface *surface = m_shsurf->surface();
+    QSize size = surface->contentSize();
+    if (size.isEmpty() || m_maxSize.isEmpty()) {
+        return;
+    }
+
+    QSize thumbSize = size.boundedTo(m_maxSize);
+    if (thumbSize != size) {
+        thumbSize = size.scaled(m_maxSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+    }
+    if (m_image.size() != thumbSize) {
+        m_image = QImage(thumbSize, QImage::Format_ARGB32_Premultiplied);
+    }
+
+    pixman_image_t *dst = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8, thumbSize.width(), thumbSize.height(),
+                                                            reinterpret_cast<uint32_t *>(m_image.bits()), m_image.bytesPerLine());
+    bool drawn = surface->drawScaledContent(dst, QRect(QPoint(0, 0), thumbSize), PIXMAN_OP_SRC);
+    pixman_image_unref(dst);
+    if (!drawn) {
+        return;
+    }
+    m_dirty = false;
+    m_requested = false;
+
+    emit updated();
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_THUMBNAIL_H
+#define ORBITAL_THUMBNAIL_H
+
+#include <QObject>
+#include <QImage>
+
+#include "timer.h"
+
+namespace Orbital {
+
+class ShellSurface;
+
+/**
+ * A downscaled copy of the content of a shell surface, made on request. A request
+ * is answered right away the first time or when the size changes, else when the
+ * surface commits, but at most once per interval. This way the shell can show
+ * previews of the windows without copying them at full resolution, and nothing
+ * is copied while it doesn't ask for them.
+ */
+class Thumbnail : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Thumbnail(ShellSurface *shsurf, int interval = 500);
+
+    // Asks for one update, scaled to fit in maxSize
+    void request(const QSize &maxSize);
+    void cancel();
+
+    const QImage &image() const { return m_image; }
+
+signals:
+    void updated();
+
+private:
+    void committed();
+    void refresh();
+
+    ShellSurface *m_shsurf;
+    QSize m_maxSize;
+    QImage m_image;
+    Timer m_timer;
+    int m_interval;
+    bool m_scheduled;
+    bool m_requested;
+    bool m_dirty;
+};
+
+}
+
+#endif
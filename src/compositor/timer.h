@@ -22,6 +22,8 @@
 
 #include <functional>
 
+#include "timerwheel.h"
+
 struct wl_event_source;
 
 namespace Orbital {
@@ -33,6 +35,11 @@ public:
     ~Timer();
 
     void setRepeat(bool repeat);
+    // How late the timer is allowed to fire, so that it can be coalesced
+    // with other timers. By default it is 1/256 of the interval.
+    void setSlack(int msecs);
+    // The name used by the LoopMonitor. It must be a string literal.
+    void setName(const char *name);
     void setTimeoutHandler(const std::function<void ()> &func);
     void start(int msecs, const std::function<void ()> &func);
     void start(int msecs);
@@ -45,10 +52,12 @@ private:
     void rearm();
 
     std::function<void ()> m_func;
-    wl_event_source *m_timerSource;
+    TimerWheel::Node m_node;
     wl_event_source *m_idleSource;
     int m_interval;
+    int m_slack;
     bool m_repeat;
+    const char *m_name;
 };
 
 }
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "timerwheel.h"
+
+namespace Orbital {
+
+static void initHead(TimerWheel::Node *head)
+{
+    head->prev = head->next = head;
+}
+
+static bool isEmptyHead(const TimerWheel::Node *head)
+{
+    return head->next == head;
+}
+
+TimerWheel::TimerWheel(uint64_t now)
+          : m_current(now)
+          , m_now(now)
+          , m_count(0)
+          , m_rootCount(0)
+{
+    for (Node &n: m_root) {
+        initHead(&n);
+    }
+    for (auto &level: m_levels) {
+        for (Node &n: level) {
+            initHead(&n);
+        }
+    }
+    initHead(&m_expired);
+}
+
+TimerWheel::~TimerWheel()
+{
+    auto clear = [](Node *head) {
+        while (!isEmptyHead(head)) {
+            unlink(head->next);
+        }
+    };
+    for (Node &n: m_root) {
+        clear(&n);
+    }
+    for (auto &level: m_levels) {
+        for (Node &n: level) {
+            clear(&n);
+        }
+    }
+    clear(&m_expired);
+}
+
+void TimerWheel::reset(uint64_t now)
+{
+    if (m_count == 0) {
+        m_current = now;
+        m_now = now;
+    }
+}
+
+void TimerWheel::add(Node *node, uint64_t expires)
+{
+    remove(node);
+    node->expires = expires;
+    insert(node);
+    ++m_count;
+}
+
+void TimerWheel::remove(Node *node)
+{
+    if (!node->isPending()) {
+        return;
+    }
+
+    if (node->level == 0) {
+        --m_rootCount;
+    }
+    unlink(node);
+    --m_count;
+}
+
+void TimerWheel::insert(Node *node)
+{
+    uint64_t expires = node->expires;
+    if (expires < m_current) {
+        // The tick it is due at was already processed, it expires right away
+        node->level = Expired;
+        link(&m_expired, node);
+        return;
+    }
+
+    uint64_t delta = expires - m_current;
+    if (delta < RootSize) {
+        node->level = 0;
+        ++m_rootCount;
+        link(&m_root[expires & (RootSize - 1)], node);
+        return;
+    }
+
+    // Timers farther than the range of the wheel are put in the last slot,
+    // and will be cascaded down again when it is reached.
+    const uint64_t maxDelta = (1ull << (RootBits + NumLevels * LevelBits)) - 1;
+    if (delta > maxDelta) {
+        expires = m_current + maxDelta;
+        delta = maxDelta;
+    }
+    for (int l = 0; l < NumLevels; ++l) {
+        if (delta < 1ull << (RootBits + (l + 1) * LevelBits)) {
+            node->level = l + 1;
+            link(&m_levels[l][levelIndex(expires, l)], node);
+            return;
+        }
+    }
+}
+
+void TimerWheel::cascade(int level)
+{
+    Node *head = &m_levels[level][levelIndex(m_current, level)];
+    while (!isEmptyHead(head)) {
+        Node *node = head->next;
+        unlink(node);
+        insert(node);
+    }
+}
+
+TimerWheel::Node *TimerWheel::takeExpired(uint64_t now)
+{
+    m_now = std::max(m_now, now);
+    while (isEmptyHead(&m_expired) && m_current <= now) {
+        if (m_rootCount == 0 && (m_current & (RootSize - 1)) != 0) {
+            // Nothing can expire before the next cascade, skip there
+            uint64_t next = (m_current | (RootSize - 1)) + 1;
+            if (next > now) {
+                m_current = now + 1;
+                break;
+            }
+            m_current = next;
+        }
+
+        if ((m_current & (RootSize - 1)) == 0) {
+            for (int l = 0; l < NumLevels; ++l) {
+                cascade(l);
+                if (levelIndex(m_current, l) != 0) {
+                    break;
+                }
+            }
+        }
+
+        Node *head = &m_root[m_current & (RootSize - 1)];
+        while (!isEmptyHead(head)) {
+            Node *node = head->next;
+            unlink(node);
+            node->level = Expired;
+            link(&m_expired, node);
+            --m_rootCount;
+        }
+        ++m_current;
+    }
+
+    if (isEmptyHead(&m_expired)) {
+        return nullptr;
+    }
+
+    Node *node = m_expired.next;
+    unlink(node);
+    --m_count;
+    return node;
+}
+
+uint64_t TimerWheel::nextExpiry() const
+{
+    if (!isEmptyHead(&m_expired)) {
+        return m_now;
+    }
+
+    uint64_t expiry = NoExpiry;
+    if (m_rootCount > 0) {
+        for (int i = 0; i < RootSize; ++i) {
+            if (!isEmptyHead(&m_root[(m_current + i) & (RootSize - 1)])) {
+                expiry = m_current + i;
+                break;
+            }
+        }
+    }
+
+    for (int l = 0; l < NumLevels; ++l) {
+        // The current slot was already cascaded, unless the wheel is right
+        // at its boundary, in which case it will be cascaded on the next tick
+        uint64_t start = levelIndex(m_current, l);
+        bool aligned = (m_current & ((1ull << (RootBits + l * LevelBits)) - 1)) == 0;
+        int first = aligned ? 0 : 1;
+        for (int i = first; i < first + LevelSize; ++i) {
+            const Node *head = &m_levels[l][(start + i) & (LevelSize - 1)];
+            if (isEmptyHead(head)) {
+                continue;
+            }
+            for (const Node *n = head->next; n != head; n = n->next) {
+                expiry = std::min(expiry, std::max(n->expires, m_current));
+            }
+            break;
+        }
+    }
+    return expiry;
+}
+
+uint64_t TimerWheel::applySlack(uint64_t expires, uint32_t slack)
+{
+    uint64_t limit = expires + slack;
+    uint64_t mask = expires ^ limit;
+    if (slack == 0 || mask == 0) {
+        return expires;
+    }
+
+    int bit = 63 - __builtin_clzll(mask);
+    mask = (1ull << bit) - 1;
+    return limit & ~mask;
+}
+
+void TimerWheel::link(Node *head, Node *node)
+{
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+void TimerWheel::unlink(Node *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+    node->level = -1;
+}
+
+uint64_t TimerWheel::levelIndex(uint64_t time, int level)
+{
+    return (time >> (RootBits + level * LevelBits)) & (LevelSize - 1);
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_TIMERWHEEL_H
+#define ORBITAL_TIMERWHEEL_H
+
+#include <stdint.h>
+
+namespace Orbital {
+
+/**
+ * A hierarchical timer wheel with a resolution of one millisecond.
+ * The first level has one slot per tick for the next 256 ticks, the four
+ * other levels have 64 slots each, covering 64 times the range of the level
+ * below. The timers in the upper levels are cascaded down as the time
+ * advances, so adding and removing a timer are O(1) operations.
+ */
+class TimerWheel
+{
+public:
+    struct Node {
+        Node() : prev(nullptr), next(nullptr), expires(0), level(-1), callback(nullptr), data(nullptr) {}
+        bool isPending() const { return level >= 0; }
+
+        Node *prev;
+        Node *next;
+        uint64_t expires;
+        int level;
+
+        // Not used by the wheel, for the users of the expired nodes
+        void (*callback)(void *data);
+        void *data;
+    };
+
+    static const uint64_t NoExpiry = UINT64_MAX;
+
+    explicit TimerWheel(uint64_t now = 0);
+    ~TimerWheel();
+
+    // Moves the wheel to the given time, only valid when it is empty
+    void reset(uint64_t now);
+
+    void add(Node *node, uint64_t expires);
+    void remove(Node *node);
+    bool isEmpty() const { return m_count == 0; }
+
+    /**
+     * Returns the next node expired at the given time, removing it from
+     * the wheel, or nullptr if there are no more.
+     */
+    Node *takeExpired(uint64_t now);
+    // Returns the time of the next expiry, or NoExpiry
+    uint64_t nextExpiry() const;
+
+    // Rounds the expiry time up to the coarsest granularity that still
+    // fits in [expires, expires + slack], so that nearby timers expire together.
+    static uint64_t applySlack(uint64_t expires, uint32_t slack);
+
+private:
+    static const int RootBits = 8;
+    static const int LevelBits = 6;
+    static const int RootSize = 1 << RootBits;
+    static const int LevelSize = 1 << LevelBits;
+    static const int NumLevels = 4;
+    static const int Expired = NumLevels + 1;
+
+    void insert(Node *node);
+    void cascade(int level);
+    static void link(Node *head, Node *node);
+    static void unlink(Node *node);
+    static uint64_t levelIndex(uint64_t time, int level);
+
+    // The next tick to process, and the time the wheel was last advanced to
+    uint64_t m_current;
+    uint64_t m_now;
+    uint32_t m_count;
+    uint32_t m_rootCount;
+    Node m_root[RootSize];
+    Node m_levels[NumLevels][LevelSize];
+    Node m_expired;
+};
+
+}
+
+#endif
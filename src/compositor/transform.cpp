@@ -17,74 +17,26 @@
  * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <matrix.h>
+#include <compositor.h>
 
 #include "transform.h"
 
 namespace Orbital {
 
-Transform::Transform()
-         : m_view(nullptr)
+void Transform::toMatrix(weston_matrix *matrix) const
 {
-    wl_list_init(&m_transform.link);
-    reset();
-}
-
-Transform::Transform(const Transform &t)
-         : Transform()
-{
-    *this = t;
-}
-
-void Transform::reset()
-{
-    weston_matrix_init(&m_transform.matrix);
-}
-
-void Transform::scale(double x, double y)
-{
-    weston_matrix_scale(&m_transform.matrix, x, y, 1);
-}
-
-void Transform::translate(double x, double y)
-{
-    weston_matrix_translate(&m_transform.matrix, x, y, 0);
-}
-
-Transform Transform::interpolate(const Transform &t1, const Transform &t2, double v)
-{
-    Transform t;
-
-    for (int i = 0; i < 16; ++i) {
-        t.m_transform.matrix.d[i] = t1.m_transform.matrix.d[i] * (1. - v) + t2.m_transform.matrix.d[i] * v;
+    weston_matrix_init(matrix);
+    if (m_type == Type::Identity) {
+        return;
     }
-    t.m_transform.matrix.type = t1.m_transform.matrix.type | t2.m_transform.matrix.type;
-
-    return t;
-}
-
-Transform &Transform::operator=(const Transform &t)
-{
-    wl_list_remove(&m_transform.link);
-    wl_list_init(&m_transform.link);
-    m_transform = t.m_transform;
-    wl_list_init(&m_transform.link);
-
-    if (m_view) {
-        wl_list_insert(&m_view->geometry.transformation_list, &m_transform.link);
-    }
-
-    return *this;
-}
-
-void Transform::setView(weston_view *v)
-{
-    wl_list_remove(&m_transform.link);
-    wl_list_init(&m_transform.link);
-    m_view = v;
 
-    if (m_view) {
-        wl_list_insert(&m_view->geometry.transformation_list, &m_transform.link);
+    matrix->d[0] = m_sx;
+    matrix->d[5] = m_sy;
+    matrix->d[12] = m_tx;
+    matrix->d[13] = m_ty;
+    matrix->type = WESTON_MATRIX_TRANSFORM_TRANSLATE;
+    if (m_type == Type::Scale) {
+        matrix->type |= WESTON_MATRIX_TRANSFORM_SCALE;
     }
 }
 
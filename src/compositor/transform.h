@@ -21,43 +21,98 @@
 #define ORBITAL_TRANSFORM_H
 
 #include <QDebug>
+#include <QPointF>
 
-#include <compositor.h>
+struct weston_matrix;
 
 namespace Orbital {
 
-class View;
-
+/**
+ * A scale followed by a translation, which is all the shell needs. It is kept
+ * as its components and knows its own type, so that copying and interpolating
+ * it is cheap, and the 4x4 matrix weston uses is only built when the transform
+ * is applied to a view.
+ */
 class Transform {
 public:
-    Transform();
-    Transform(const Transform &t);
-
-    void reset();
-    void scale(double x, double y);
-    void translate(double x, double y);
+    enum class Type : unsigned char {
+        Identity,
+        Translate,
+        // a scale, possibly followed by a translation
+        Scale,
+    };
+
+    Transform() { reset(); }
+
+    void reset()
+    {
+        m_sx = m_sy = 1.;
+        m_tx = m_ty = 0.;
+        m_type = Type::Identity;
+    }
+    void scale(double x, double y)
+    {
+        m_sx *= x;
+        m_sy *= y;
+        m_tx *= x;
+        m_ty *= y;
+        updateType();
+    }
+    void translate(double x, double y)
+    {
+        m_tx += x;
+        m_ty += y;
+        updateType();
+    }
 
-    static Transform interpolate(const Transform &t1, const Transform &t2, double v);
+    Type type() const { return m_type; }
+    bool isIdentity() const { return m_type == Type::Identity; }
+    double scaleX() const { return m_sx; }
+    double scaleY() const { return m_sy; }
+    double translateX() const { return m_tx; }
+    double translateY() const { return m_ty; }
+
+    QPointF map(const QPointF &p) const { return QPointF(p.x() * m_sx + m_tx, p.y() * m_sy + m_ty); }
+    void toMatrix(weston_matrix *matrix) const;
+
+    static Transform interpolate(const Transform &t1, const Transform &t2, double v)
+    {
+        Transform t;
+        t.m_sx = t1.m_sx * (1. - v) + t2.m_sx * v;
+        t.m_sy = t1.m_sy * (1. - v) + t2.m_sy * v;
+        t.m_tx = t1.m_tx * (1. - v) + t2.m_tx * v;
+        t.m_ty = t1.m_ty * (1. - v) + t2.m_ty * v;
+        t.updateType();
+        return t;
+    }
 
-    Transform &operator=(const Transform &t);
+    bool operator==(const Transform &t) const
+    {
+        return m_sx == t.m_sx && m_sy == t.m_sy && m_tx == t.m_tx && m_ty == t.m_ty;
+    }
+    bool operator!=(const Transform &t) const { return !(*this == t); }
 
 private:
-    void setView(weston_view *v);
-
-    weston_transform m_transform;
-    weston_view *m_view;
+    void updateType()
+    {
+        if (m_sx != 1. || m_sy != 1.) {
+            m_type = Type::Scale;
+        } else if (m_tx != 0. || m_ty != 0.) {
+            m_type = Type::Translate;
+        } else {
+            m_type = Type::Identity;
+        }
+    }
 
-    friend View;
-    friend QDebug operator<<(QDebug dbg, const Transform &t);
+    double m_sx, m_sy;
+    double m_tx, m_ty;
+    Type m_type;
 };
 
 inline QDebug operator<<(QDebug dbg, const Transform &t)
 {
-    dbg.nospace() << "Transform(";
-    for (int i = 0; i < 16; ++i) {
-        dbg.space() << t.m_transform.matrix.d[i];
-    }
-    dbg.nospace() << ")";
+    dbg.nospace() << "Transform(scale " << t.scaleX() << ", " << t.scaleY()
+                  << " translate " << t.translateX() << ", " << t.translateY() << ")";
 
     return dbg.space();
 }
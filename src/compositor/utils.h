@@ -23,6 +23,7 @@
 #include <utility>
 #include <functional>
 #include <vector>
+#include <unordered_map>
 
 #include <wayland-server-core.h>
 
@@ -70,6 +71,27 @@ private:
     bool m_isSet;
 };
 
+/**
+ * Maps a weston object to the Orbital object wrapping it in constant time.
+ * The wrapper must add itself on construction and remove itself when
+ * either it or the weston object is destroyed.
+ */
+template<class W, class T>
+class WrapperMap
+{
+public:
+    inline void insert(const W *w, T *t) { m_map[w] = t; }
+    inline void remove(const W *w) { m_map.erase(w); }
+    inline T *find(const W *w) const {
+        auto it = m_map.find(w);
+        return it == m_map.end() ? nullptr : it->second;
+    }
+    inline size_t size() const { return m_map.size(); }
+
+private:
+    std::unordered_map<const W *, T *> m_map;
+};
+
 }
 
 
@@ -95,6 +117,7 @@ public:
     inline void setNotify(const Notify &n) { m_notify = n; }
 
     inline void connect(wl_signal *signal) { wl_signal_add(signal, this); }
+    inline void disconnect() { wl_list_remove(&link); wl_list_init(&link); }
 
 private:
     inline static void fire(wl_listener *listener, void *data) {
@@ -28,9 +28,39 @@
 #include "layer.h"
 #include "surface.h"
 #include "compositor.h"
+#include "viewindex.h"
+#include "utils.h"
 
 namespace Orbital {
 
+static WrapperMap<weston_view, View> s_views;
+
+// Returns the outputs the view and its children were on and are now on
+static uint32_t updateOutputs(weston_view *view)
+{
+    uint32_t mask = view->output_mask;
+    weston_view_update_transform(view);
+    mask |= view->output_mask;
+
+    weston_view *child;
+    wl_list_for_each(child, &view->geometry.child_list, geometry.parent_link) {
+        mask |= updateOutputs(child);
+    }
+    return mask;
+}
+
+// Repaint only the outputs affected by the change, not all of them
+static void scheduleRepaint(weston_view *view)
+{
+    uint32_t mask = updateOutputs(view);
+    weston_output *output;
+    wl_list_for_each(output, &view->surface->compositor->output_list, link) {
+        if (mask & (1u << output->id)) {
+            weston_output_schedule_repaint(output);
+        }
+    }
+}
+
 struct Listener {
     wl_listener listener;
     View *view;
@@ -39,6 +69,10 @@ struct Listener {
 void View::viewDestroyed(wl_listener *listener, void *data)
 {
     View *view = reinterpret_cast<Listener *>(listener)->view;
+    if (ViewIndex *index = view->index()) {
+        index->viewDestroyed(view, view->m_view);
+    }
+    s_views.remove(view->m_view);
     view->m_view = nullptr;
     wl_list_remove(&listener->link);
     delete view;
@@ -59,11 +93,12 @@ View::View(Surface *s, weston_view *view)
     , m_layer(nullptr)
     , m_activatable(true)
 {
-    m_transform.setView(m_view);
+    wl_list_init(&m_westonTransform.link);
 
     m_listener->listener.notify = viewDestroyed;
     m_listener->view = this;
     wl_signal_add(&m_view->destroy_signal, &m_listener->listener);
+    s_views.insert(m_view, this);
 
     s->m_views.push_back(this);
 }
@@ -72,6 +107,10 @@ View::~View()
 {
     m_surface->m_views.erase(std::find(m_surface->m_views.begin(), m_surface->m_views.end(), this));
     if (m_view) {
+        if (ViewIndex *index = this->index()) {
+            index->viewDestroyed(this, m_view);
+        }
+        s_views.remove(m_view);
         wl_list_remove(&m_listener->listener.link);
         if (m_creator) {
             m_creator->destroy(this, m_view);
@@ -130,19 +169,32 @@ void View::setPos(double x, double y)
 {
     weston_view_set_position(m_view, x, y);
     weston_view_geometry_dirty(m_view);
+    index()->viewMoved(m_view);
+    scheduleRepaint(m_view);
 }
 
 void View::setTransformParent(View *p)
 {
     weston_view_set_transform_parent(m_view, p ? p->m_view : nullptr);
     weston_view_update_transform(m_view);
+    index()->viewMoved(m_view);
 }
 
 void View::setTransform(const Transform &tr)
 {
     m_transform = tr;
 
+    // Leave the identity out, so weston can skip the matrix math for the view
+    wl_list_remove(&m_westonTransform.link);
+    wl_list_init(&m_westonTransform.link);
+    if (!tr.isIdentity()) {
+        tr.toMatrix(&m_westonTransform.matrix);
+        wl_list_insert(&m_view->geometry.transformation_list, &m_westonTransform.link);
+    }
+
     weston_view_geometry_dirty(m_view);
+    index()->viewMoved(m_view);
+    scheduleRepaint(m_view);
 }
 
 const Transform &View::transform() const
@@ -176,13 +228,14 @@ View *View::mainView() const
     while (view->parent_view) {
         view = view->parent_view;
     }
-    return View::fromView(view);
+    return View::wrap(view);
 }
 
 void View::update()
 {
     weston_view_geometry_dirty(m_view);
     weston_view_update_transform(m_view);
+    index()->viewMoved(m_view);
 }
 
 void View::unmap()
@@ -215,13 +268,22 @@ Surface *View::surface() const
     return m_surface;
 }
 
+ViewIndex *View::index() const
+{
+    return Compositor::fromCompositor(m_view->surface->compositor)->viewIndex();
+}
+
 View *View::fromView(weston_view *v)
 {
-    wl_listener *listener = wl_signal_get(&v->destroy_signal, viewDestroyed);
-    if (!listener) {
-        return new View(Surface::fromSurface(v->surface), v);
+    return s_views.find(v);
+}
+
+View *View::wrap(weston_view *v)
+{
+    if (View *view = s_views.find(v)) {
+        return view;
     }
-    return reinterpret_cast<Listener *>(listener)->view;
+    return new View(Surface::fromSurface(v->surface), v);
 }
 
 View *View::dispatchPointerEvent(const Pointer *pointer, wl_fixed_t fx, wl_fixed_t fy)
@@ -237,6 +299,7 @@ View *View::dispatchPointerEvent(const Pointer *pointer, wl_fixed_t fx, wl_fixed
                 return m_pointerState.target;
             }
             m_pointerState.inside = true;
+            index()->setHovered(this, true);
             m_pointerState.target = pointerEnter(pointer);
             return m_pointerState.target;
         }
@@ -244,6 +307,7 @@ View *View::dispatchPointerEvent(const Pointer *pointer, wl_fixed_t fx, wl_fixed
 
     if (m_pointerState.inside) {
         m_pointerState.inside = false;
+        index()->setHovered(this, false);
         pointerLeave(pointer);
     }
     return nullptr;
@@ -40,6 +40,8 @@ class Layer;
 class Pointer;
 class Transform;
 class Surface;
+class Compositor;
+class ViewIndex;
 struct Listener;
 
 class View;
@@ -88,7 +90,15 @@ public:
     wl_client *client() const;
     Surface *surface() const;
 
+    /**
+     * Returns the View wrapping the given weston_view, or nullptr if there is none.
+     */
     static View *fromView(weston_view *v);
+    /**
+     * Like fromView(), but creates a new View if the weston_view was not created
+     * by Orbital, e.g. for subsurfaces.
+     */
+    static View *wrap(weston_view *v);
 
     View *dispatchPointerEvent(const Pointer *p, wl_fixed_t x, wl_fixed_t y);
 
@@ -103,6 +113,7 @@ protected:
 private:
     explicit View(Surface *s, weston_view *view);
     static void viewDestroyed(wl_listener *listener, void *data);
+    ViewIndex *index() const;
 
     weston_view *m_view;
     ViewCreator *m_creator;
@@ -110,6 +121,8 @@ private:
     Listener *m_listener;
     Output *m_output;
     Transform m_transform;
+    // Only in the view's transformation list when m_transform is not the identity
+    weston_transform m_westonTransform;
     struct {
         bool inside;
         View *target;
@@ -119,7 +132,9 @@ private:
 
     friend Layer;
     friend Pointer;
+    friend Compositor;
     friend class XWayland;
+    friend class FrameThrottle;
 };
 
 }
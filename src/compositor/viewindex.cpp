@@ -0,0 +1,227 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <compositor.h>
+
+#include "viewindex.h"
+#include "compositor.h"
+#include "output.h"
+#include "view.h"
+
+namespace Orbital {
+
+static QRect boundingBox(weston_view *view)
+{
+    const pixman_box32_t *e = pixman_region32_extents(&view->transform.boundingbox);
+    return QRect(e->x1, e->y1, e->x2 - e->x1, e->y2 - e->y1);
+}
+
+ViewIndex::ViewIndex(Compositor *c)
+         : m_compositor(c)
+         , m_dirty(true)
+         , m_rebinAll(false)
+{
+    QObject::connect(c, &Compositor::outputCreated, c, [this](Output *o) {
+        QObject::connect(o, &Output::moved, m_compositor, [this]() { invalidate(); });
+        invalidate();
+    });
+    QObject::connect(c, &Compositor::outputRemoved, c, [this](Output *o) {
+        m_grids.erase(std::remove_if(m_grids.begin(), m_grids.end(), [o](const Grid &g) { return g.output == o; }), m_grids.end());
+        invalidate();
+    });
+}
+
+ViewIndex::~ViewIndex()
+{
+}
+
+void ViewIndex::invalidate()
+{
+    m_dirty = true;
+}
+
+void ViewIndex::viewMoved(weston_view *view)
+{
+    if (m_rebinAll) {
+        return;
+    }
+    // Nobody queried the index for a while, it is cheaper to look at every view
+    if (m_pending.size() >= m_records.size()) {
+        m_rebinAll = true;
+        m_pending.clear();
+        return;
+    }
+
+    m_pending.push_back(view);
+    weston_view *child;
+    wl_list_for_each(child, &view->geometry.child_list, geometry.parent_link) {
+        viewMoved(child);
+    }
+}
+
+void ViewIndex::viewDestroyed(View *view, weston_view *wv)
+{
+    setHovered(view, false);
+    m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), wv), m_pending.end());
+
+    auto it = m_records.find(wv);
+    if (it == m_records.end()) {
+        return;
+    }
+
+    for (Grid &g: m_grids) {
+        g.grid.remove(view, it->second.box);
+    }
+    m_order[it->second.order] = nullptr;
+    m_records.erase(it);
+    m_dirty = true;
+}
+
+void ViewIndex::setHovered(View *view, bool hovered)
+{
+    auto it = std::find(m_hovered.begin(), m_hovered.end(), view);
+    if (hovered && it == m_hovered.end()) {
+        m_hovered.push_back(view);
+    } else if (!hovered && it != m_hovered.end()) {
+        m_hovered.erase(it);
+    }
+}
+
+std::vector<View *> ViewIndex::candidates(int x, int y)
+{
+    update();
+
+    std::vector<View *> views;
+    for (const Grid &g: m_grids) {
+        if (g.grid.area().contains(x, y)) {
+            const auto &cell = g.grid.at(x, y);
+            views.reserve(cell.size());
+            for (const auto &entry: cell) {
+                views.push_back(entry.value);
+            }
+            return views;
+        }
+    }
+
+    // The point is out of every output, fall back to the whole list
+    views.reserve(m_order.size());
+    for (weston_view *wv: m_order) {
+        if (wv) {
+            views.push_back(m_records[wv].view);
+        }
+    }
+    return views;
+}
+
+void ViewIndex::update()
+{
+    if (m_dirty) {
+        rebuild();
+    } else {
+        rebinPending();
+    }
+}
+
+void ViewIndex::rebinPending()
+{
+    if (m_rebinAll) {
+        for (weston_view *wv: m_order) {
+            if (wv) {
+                weston_view_update_transform(wv);
+                rebin(wv, m_records[wv]);
+            }
+        }
+    } else {
+        for (weston_view *wv: m_pending) {
+            auto it = m_records.find(wv);
+            if (it != m_records.end()) {
+                weston_view_update_transform(wv);
+                rebin(wv, it->second);
+            }
+        }
+    }
+    m_pending.clear();
+    m_rebinAll = false;
+}
+
+void ViewIndex::rebuild()
+{
+    m_dirty = false;
+
+    weston_compositor *c = m_compositor->compositor();
+    weston_view *wv;
+
+    // Most of the times the stacking did not change, and only the views that moved
+    // need to be put in different cells
+    size_t i = 0;
+    bool sameOrder = true;
+    wl_list_for_each(wv, &c->view_list, link) {
+        if (i >= m_order.size() || m_order[i] != wv) {
+            sameOrder = false;
+            break;
+        }
+        ++i;
+    }
+    const auto &outputs = m_compositor->outputs();
+    bool sameOutputs = m_grids.size() == outputs.size();
+    for (size_t j = 0; sameOutputs && j < outputs.size(); ++j) {
+        sameOutputs = m_grids[j].output == outputs[j] && m_grids[j].grid.area() == outputs[j]->geometry();
+    }
+    if (sameOrder && sameOutputs && i == m_order.size()) {
+        rebinPending();
+        return;
+    }
+
+    m_pending.clear();
+    m_rebinAll = false;
+    m_records.clear();
+    m_order.clear();
+    m_grids.clear();
+    for (Output *o: outputs) {
+        m_grids.push_back({ o, SpatialGrid<View *>() });
+        m_grids.back().grid.reset(o->geometry());
+    }
+
+    wl_list_for_each(wv, &c->view_list, link) {
+        weston_view_update_transform(wv);
+
+        Record record = { (uint32_t)m_order.size(), boundingBox(wv), View::wrap(wv) };
+        for (Grid &g: m_grids) {
+            g.grid.insert(record.view, record.order, record.box);
+        }
+        m_order.push_back(wv);
+        m_records[wv] = record;
+    }
+}
+
+void ViewIndex::rebin(weston_view *view, Record &record)
+{
+    QRect box = boundingBox(view);
+    if (box == record.box) {
+        return;
+    }
+
+    for (Grid &g: m_grids) {
+        g.grid.remove(record.view, record.box);
+        g.grid.insert(record.view, record.order, box);
+    }
+    record.box = box;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ORBITAL_VIEWINDEX_H
+#define ORBITAL_VIEWINDEX_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "spatialgrid.h"
+
+struct weston_view;
+
+namespace Orbital {
+
+class Compositor;
+class Output;
+class View;
+
+/**
+ * Per-output spatial index over the bounding boxes of the views in the
+ * compositor's view list, used to pick views under the pointer without
+ * walking the whole scene.
+ * Moved views are rebinned lazily on the next query, while a change in the
+ * stacking (or a repaint, after which weston may have rebuilt its view list)
+ * triggers a revalidation of the whole list. When the list turns out to be
+ * unchanged only the moved views are rebinned.
+ */
+class ViewIndex
+{
+public:
+    explicit ViewIndex(Compositor *c);
+    ~ViewIndex();
+
+    void invalidate();
+    void viewMoved(weston_view *view);
+    void viewDestroyed(View *view, weston_view *wv);
+    void setHovered(View *view, bool hovered);
+
+    /**
+     * Returns the views whose bounding box overlaps the cell containing
+     * the point, top to bottom.
+     */
+    std::vector<View *> candidates(int x, int y);
+    std::vector<View *> hovered() const { return m_hovered; }
+
+private:
+    struct Record {
+        uint32_t order;
+        QRect box;
+        View *view;
+    };
+    struct Grid {
+        Output *output;
+        SpatialGrid<View *> grid;
+    };
+
+    void update();
+    void rebuild();
+    void rebinPending();
+    void rebin(weston_view *view, Record &record);
+
+    Compositor *m_compositor;
+    std::vector<Grid> m_grids;
+    std::unordered_map<weston_view *, Record> m_records;
+    std::vector<weston_view *> m_order;
+    std::vector<weston_view *> m_pending;
+    std::vector<View *> m_hovered;
+    bool m_dirty;
+    bool m_rebinAll;
+};
+
+}
+
+#endif
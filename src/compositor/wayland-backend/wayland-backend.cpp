@@ -29,7 +29,7 @@ WaylandBackend::WaylandBackend()
 
 }
 
-bool WaylandBackend::init(weston_compositor *c)
+bool WaylandBackend::init(weston_compositor *c, const Config &)
 {
     weston_wayland_backend_config config;
     config.base.struct_version = WESTON_WAYLAND_BACKEND_CONFIG_VERSION;
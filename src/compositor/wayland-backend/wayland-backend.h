@@ -33,7 +33,7 @@ class WaylandBackend : public Backend
 public:
     WaylandBackend();
 
-    bool init(weston_compositor *c) override;
+    bool init(weston_compositor *c, const Config &config) override;
 
 private:
     Listener m_pendingListener;
@@ -49,6 +49,7 @@ AbstractWorkspace::View::View(Compositor *c, Output *o)
     m_transformAnim.anim.setStart(0);
     m_transformAnim.anim.setTarget(1);
     m_transformAnim.anim.update.connect(this, &AbstractWorkspace::View::updateAnim);
+    m_transformAnim.anim.done.connect([this]() { transformDone(); });
     resetMask();
 }
 
@@ -77,6 +78,11 @@ void AbstractWorkspace::View::setTransformParent(Orbital::View *p)
     m_root->view->setTransformParent(p);
 }
 
+Orbital::View *AbstractWorkspace::View::rootView() const
+{
+    return m_root->view;
+}
+
 void AbstractWorkspace::View::takeView(Orbital::View *p)
 {
     p->setTransformParent(m_root->view);
@@ -99,15 +105,17 @@ void AbstractWorkspace::View::setTransform(const Transform &tf, bool animate)
         m_transformAnim.orig = transform();
         m_transformAnim.anim.run(m_output, 300);
     } else {
+        m_transformAnim.anim.stop();
         updateAnim(1.);
+        m_output->repaint();
     }
 }
 
 void AbstractWorkspace::View::updateAnim(double v)
 {
+    // The output timeline schedules the repaint while animating
     m_root->view->setTransform(Transform::interpolate(m_transformAnim.orig, m_transformAnim.target, v));
     resetMask();
-    m_output->repaint();
 }
 
 const Transform &AbstractWorkspace::View::transform() const
@@ -115,6 +123,11 @@ const Transform &AbstractWorkspace::View::transform() const
     return m_root->view->transform();
 }
 
+bool AbstractWorkspace::View::isAnimating() const
+{
+    return m_transformAnim.anim.isRunning();
+}
+
 
 Workspace::Workspace(Shell *shell, int id)
          : Object(shell)
@@ -123,7 +136,7 @@ Workspace::Workspace(Shell *shell, int id)
          , m_x(0)
          , m_y(0)
 {
-    setMask(1 << m_id);
+    setMask(WorkspaceMask(m_id));
     connect(shell->compositor(), &Compositor::outputRemoved, this, &Workspace::outputRemoved);
     connect(shell->compositor(), &Compositor::outputCreated, this, &Workspace::newOutput);
 
@@ -176,7 +189,7 @@ void Workspace::activate(Output *o)
 Orbital::View *Workspace::topView() const
 {
     View *view = m_views.begin()->second;
-    return view->m_layer->topView();
+    return view->m_layer ? view->m_layer->topView() : nullptr;
 }
 
 int Workspace::id() const
@@ -221,19 +234,34 @@ Workspace::View::View(Workspace *ws, Output *o)
                : AbstractWorkspace::View(ws->compositor(), o)
                , m_workspace(ws)
                , m_output(o)
-               , m_backgroundLayer(new Layer(ws->compositor()->layer(Compositor::Layer::Background)))
-               , m_layer(new Layer(ws->compositor()->layer(Compositor::Layer::Apps)))
-               , m_fullscreenLayer(new Layer(ws->compositor()->layer(Compositor::Layer::Fullscreen)))
+               , m_backgroundLayer(nullptr)
+               , m_layer(nullptr)
+               , m_fullscreenLayer(nullptr)
+               , m_snapshotLayer(nullptr)
                , m_background(nullptr)
+               , m_snapshot(nullptr)
+               , m_visible(false)
+               , m_fullscreen(false)
+               , m_layersLinked(false)
+               , m_fullscreenLinked(false)
+               , m_snapshotLinked(false)
 {
+    // The layers are created and linked when the pager first shows the workspace
+    // on the output, or when a view is put in it
 }
 
 Workspace::View::~View()
 {
+    // when the output is removed this runs after it is gone
+    const auto &outputs = m_workspace->compositor()->outputs();
+    if (m_fullscreen && std::find(outputs.begin(), outputs.end(), m_output) != outputs.end()) {
+        m_output->setFullscreen(this, false);
+    }
     delete m_background;
     delete m_backgroundLayer;
     delete m_layer;
     delete m_fullscreenLayer;
+    delete m_snapshotLayer;
 }
 
 QPoint Workspace::View::logicalPos() const
@@ -244,7 +272,128 @@ QPoint Workspace::View::logicalPos() const
 bool Workspace::View::ownsView(Orbital::View *view) const
 {
     Layer *l = view->layer();
-    return l == m_layer || l == m_backgroundLayer || l == m_fullscreenLayer;
+    return l && (l == m_layer || l == m_backgroundLayer || l == m_fullscreenLayer);
+}
+
+void Workspace::View::setVisible(bool visible)
+{
+    if (m_visible == visible) {
+        return;
+    }
+
+    m_visible = visible;
+    if (visible) {
+        createLayers();
+    }
+    updateFullscreen();
+    updateLayers();
+    // the views of the unlinked layers won't damage their old area by themselves
+    weston_output_damage(m_output->output());
+    emit m_workspace->visibilityChanged(m_output, visible);
+}
+
+void Workspace::View::updateFullscreen()
+{
+    // The fullscreen layer only contains views that are opaque over the whole output, either
+    // by themselves or with their black surface, but they only cover it if the workspace
+    // is not moved or scaled
+    bool fullscreen = m_visible && !m_snapshot && m_fullscreenLayer && m_fullscreenLayer->topView() && mask() == m_output->geometry();
+    if (m_fullscreen == fullscreen) {
+        return;
+    }
+
+    m_fullscreen = fullscreen;
+    updateLayers();
+    m_output->setFullscreen(this, fullscreen);
+    weston_output_damage(m_output->output());
+}
+
+void Workspace::View::createLayers()
+{
+    if (m_layer) {
+        return;
+    }
+
+    m_backgroundLayer = new Layer;
+    m_layer = new Layer;
+    m_fullscreenLayer = new Layer;
+    m_snapshotLayer = new Layer;
+    for (Layer *l: { m_backgroundLayer, m_layer, m_fullscreenLayer, m_snapshotLayer }) {
+        l->setMask(m_layerMask.x(), m_layerMask.y(), m_layerMask.width(), m_layerMask.height());
+    }
+}
+
+void Workspace::View::updateLayers()
+{
+    if (!m_layer) {
+        return;
+    }
+
+    // setParent() restacks the layer among its siblings, so only do it when needed
+    Compositor *c = m_workspace->compositor();
+    bool live = m_visible && !m_snapshot;
+    if (m_fullscreenLinked != live) {
+        m_fullscreenLinked = live;
+        m_fullscreenLayer->setParent(live ? c->layer(Compositor::Layer::Fullscreen) : nullptr);
+    }
+
+    bool linked = live && !m_fullscreen;
+    if (m_layersLinked != linked) {
+        m_layersLinked = linked;
+        m_backgroundLayer->setParent(linked ? c->layer(Compositor::Layer::Background) : nullptr);
+        m_layer->setParent(linked ? c->layer(Compositor::Layer::Apps) : nullptr);
+    }
+
+    bool snapshot = m_visible && m_snapshot;
+    if (m_snapshotLinked != snapshot) {
+        m_snapshotLinked = snapshot;
+        m_snapshotLayer->setParent(snapshot ? c->layer(Compositor::Layer::Apps) : nullptr);
+    }
+}
+
+void Workspace::View::setSnapshot(Orbital::View *view)
+{
+    if (m_snapshot == view) {
+        return;
+    }
+
+    if (m_snapshot) {
+        QObject::disconnect(m_snapshot, &QObject::destroyed, rootView(), nullptr);
+        m_snapshot->unmap();
+    }
+    m_snapshot = view;
+    if (view) {
+        createLayers();
+        takeView(view);
+        m_snapshotLayer->addView(view);
+        QObject::connect(view, &QObject::destroyed, rootView(), [this]() {
+            m_snapshot = nullptr;
+            updateLayers();
+            updateFullscreen();
+        });
+    }
+    updateLayers();
+    updateFullscreen();
+    weston_output_damage(m_output->output());
+}
+
+std::vector<Orbital::View *> Workspace::View::views() const
+{
+    if (!m_layer) {
+        return std::vector<Orbital::View *>();
+    }
+
+    std::vector<Orbital::View *> views = m_backgroundLayer->views();
+    for (Layer *l: { m_layer, m_fullscreenLayer }) {
+        std::vector<Orbital::View *> v = l->views();
+        views.insert(views.end(), v.begin(), v.end());
+    }
+    return views;
+}
+
+void Workspace::View::transformDone()
+{
+    m_workspace->pager()->updateVisibility(m_output);
 }
 
 void Workspace::View::setBackground(Surface *s)
@@ -259,6 +408,7 @@ void Workspace::View::setBackground(Surface *s)
     // increase the ref count for the background, so to keep it alive when the shell client
     // crashes, until a new one is set
     s->ref();
+    createLayers();
     m_background = new Orbital::View(s);
     takeView(m_background);
     m_backgroundLayer->addView(m_background);
@@ -266,13 +416,18 @@ void Workspace::View::setBackground(Surface *s)
 
 void Workspace::View::setMask(const QRect &r)
 {
-    m_backgroundLayer->setMask(r.x(), r.y(), r.width(), r.height());
-    m_layer->setMask(r.x(), r.y(), r.width(), r.height());
-    m_fullscreenLayer->setMask(r.x(), r.y(), r.width(), r.height());
+    m_layerMask = r;
+    if (m_layer) {
+        for (Layer *l: { m_backgroundLayer, m_layer, m_fullscreenLayer, m_snapshotLayer }) {
+            l->setMask(r.x(), r.y(), r.width(), r.height());
+        }
+    }
+    updateFullscreen();
 }
 
 void Workspace::View::configure(Orbital::View *view)
 {
+    createLayers();
     if (view->layer() != m_layer) {
         m_layer->addView(view);
         takeView(view);
@@ -281,10 +436,16 @@ void Workspace::View::configure(Orbital::View *view)
 
 void Workspace::View::configureFullscreen(Orbital::View *view, Orbital::View *blackSurface)
 {
+    createLayers();
+    if (view->layer() != m_fullscreenLayer) {
+        // the view may be destroyed without being unmapped first
+        QObject::connect(view, &QObject::destroyed, rootView(), [this]() { updateFullscreen(); });
+    }
     m_fullscreenLayer->addView(blackSurface);
     m_fullscreenLayer->addView(view);
     takeView(view);
     takeView(blackSurface);
+    updateFullscreen();
 }
 
 }
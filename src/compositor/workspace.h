@@ -27,6 +27,7 @@
 #include "interface.h"
 #include "transform.h"
 #include "animation.h"
+#include "workspacemask.h"
 
 struct weston_surface;
 
@@ -48,7 +49,7 @@ class Transform;
 class AbstractWorkspace
 {
 protected:
-    AbstractWorkspace() : m_mask(0) {}
+    AbstractWorkspace() {}
 
 public:
     class View
@@ -60,6 +61,8 @@ public:
         virtual void configure(Orbital::View *view) = 0;
         virtual void configureFullscreen(Orbital::View *view, Orbital::View *blackSurface) = 0;
         virtual void setMask(const QRect &mask) {}
+        // Whether the workspace is in the scene of the output
+        virtual bool isVisible() const { return true; }
 
         QPointF map(double x, double y) const;
         QPoint pos() const;
@@ -70,6 +73,11 @@ public:
         inline QRect mask() const { return m_mask; }
         void setTransform(const Transform &tf, bool animate);
         const Transform &transform() const;
+        bool isAnimating() const;
+
+    protected:
+        virtual void transformDone() {}
+        Orbital::View *rootView() const;
 
     private:
         void updateAnim(double v);
@@ -86,13 +94,13 @@ public:
     virtual View *viewForOutput(Output *o) = 0;
     virtual void activate(Output *o) = 0;
 
-    int mask() const { return m_mask; }
+    const WorkspaceMask &mask() const { return m_mask; }
 
 protected:
-    void setMask(int m) { m_mask = m; }
+    void setMask(const WorkspaceMask &m) { m_mask = m; }
 
 private:
-    int m_mask;
+    WorkspaceMask m_mask;
 };
 
 template<class T>
@@ -102,7 +110,6 @@ typename T::View *workspaceViewForOutput(T *ws, Output *o)
     return static_cast<typename T::View *>(v);
 }
 
-// Due to mask() being an int, we can have up to 31 workspaces
 class Workspace : public Object, public AbstractWorkspace
 {
     Q_OBJECT
@@ -121,18 +128,45 @@ public:
 
         bool ownsView(Orbital::View *view) const;
 
+        // Links or unlinks the workspace layers from the compositor's layer list
+        void setVisible(bool visible);
+        bool isVisible() const override { return m_visible; }
+        // While a fullscreen view covers the whole output nothing below it is visible,
+        // so the background and apps layers and the output panels are unlinked
+        void updateFullscreen();
+        bool isFullscreen() const { return m_fullscreen; }
+        // Shows the given view, usually a picture of the workspace, instead of its layers.
+        // The view is in the workspace coordinates. Pass nullptr to go back to the live layers.
+        void setSnapshot(Orbital::View *view);
+        Orbital::View *snapshot() const { return m_snapshot; }
+        // The background, normal and fullscreen views, from the bottom one to the top one
+        std::vector<Orbital::View *> views() const;
+
         Workspace *workspace() const { return m_workspace; }
 
     protected:
         void setMask(const QRect &r) override;
+        void transformDone() override;
 
     private:
+        void createLayers();
+        void updateLayers();
+
         Workspace *m_workspace;
         Output *m_output;
+        // Created the first time they are needed
         Layer *m_backgroundLayer;
         Layer *m_layer;
         Layer *m_fullscreenLayer;
+        Layer *m_snapshotLayer;
         Orbital::View *m_background;
+        Orbital::View *m_snapshot;
+        QRect m_layerMask;
+        bool m_visible;
+        bool m_fullscreen;
+        bool m_layersLinked;
+        bool m_fullscreenLinked;
+        bool m_snapshotLinked;
 
         friend Pager;
         friend Workspace;
@@ -154,6 +188,7 @@ public:
 
 signals:
     void positionChanged(int x, int y);
+    void visibilityChanged(Output *output, bool visible);
 
 private:
     void outputRemoved(Output *o);
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ORBITAL_WORKSPACEMASK_H
+#define ORBITAL_WORKSPACEMASK_H
+
+#include <stdint.h>
+
+#include <vector>
+#include <ostream>
+#include <algorithm>
+
+namespace Orbital {
+
+/**
+ * A set of workspaces, by id. The first 64 ids are kept inline so that the usual
+ * masks don't allocate, higher ones grow the set as needed. A mask can also stand
+ * for all the workspaces, as for the surfaces not bound to any of them.
+ */
+class WorkspaceMask
+{
+public:
+    WorkspaceMask() : m_bits(0), m_all(false) {}
+    explicit WorkspaceMask(int id) : WorkspaceMask() { add(id); }
+
+    static WorkspaceMask all()
+    {
+        WorkspaceMask m;
+        m.m_all = true;
+        return m;
+    }
+
+    bool isAll() const { return m_all; }
+    bool isEmpty() const
+    {
+        return !m_all && !m_bits && std::all_of(m_more.begin(), m_more.end(), [](uint64_t w) { return w == 0; });
+    }
+
+    void add(int id)
+    {
+        if (id < 64) {
+            m_bits |= bit(id);
+            return;
+        }
+        size_t i = id / 64 - 1;
+        if (i >= m_more.size()) {
+            m_more.resize(i + 1, 0);
+        }
+        m_more[i] |= bit(id);
+    }
+    bool contains(int id) const
+    {
+        if (m_all) {
+            return true;
+        }
+        if (id < 64) {
+            return m_bits & bit(id);
+        }
+        size_t i = id / 64 - 1;
+        return i < m_more.size() && (m_more[i] & bit(id));
+    }
+    bool intersects(const WorkspaceMask &m) const
+    {
+        if (m_all || m.m_all) {
+            return m_all ? !m.isEmpty() : !isEmpty();
+        }
+        if (m_bits & m.m_bits) {
+            return true;
+        }
+        size_t n = std::min(m_more.size(), m.m_more.size());
+        for (size_t i = 0; i < n; ++i) {
+            if (m_more[i] & m.m_more[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    WorkspaceMask &operator|=(const WorkspaceMask &m)
+    {
+        m_all = m_all || m.m_all;
+        m_bits |= m.m_bits;
+        if (m_more.size() < m.m_more.size()) {
+            m_more.resize(m.m_more.size(), 0);
+        }
+        for (size_t i = 0; i < m.m_more.size(); ++i) {
+            m_more[i] |= m.m_more[i];
+        }
+        return *this;
+    }
+
+    bool operator==(const WorkspaceMask &m) const
+    {
+        if (m_all || m.m_all) {
+            return m_all == m.m_all;
+        }
+        if (m_bits != m.m_bits) {
+            return false;
+        }
+        size_t n = std::max(m_more.size(), m.m_more.size());
+        for (size_t i = 0; i < n; ++i) {
+            if ((i < m_more.size() ? m_more[i] : 0) != (i < m.m_more.size() ? m.m_more[i] : 0)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const WorkspaceMask &m) const { return !(*this == m); }
+
+private:
+    static uint64_t bit(int id) { return uint64_t(1) << (id % 64); }
+
+    uint64_t m_bits;
+    std::vector<uint64_t> m_more;
+    bool m_all;
+
+    friend std::ostream &operator<<(std::ostream &os, const WorkspaceMask &m);
+};
+
+inline std::ostream &operator<<(std::ostream &os, const WorkspaceMask &m)
+{
+    if (m.m_all) {
+        return os << "all";
+    }
+    os << "{";
+    bool first = true;
+    for (size_t w = 0; w <= m.m_more.size(); ++w) {
+        uint64_t bits = w == 0 ? m.m_bits : m.m_more[w - 1];
+        for (int i = 0; i < 64; ++i) {
+            if (bits & (uint64_t(1) << i)) {
+                os << (first ? "" : ", ") << w * 64 + i;
+                first = false;
+            }
+        }
+    }
+    return os << "}";
+}
+
+}
+
+#endif
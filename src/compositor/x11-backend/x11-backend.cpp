@@ -29,7 +29,7 @@ X11Backend::X11Backend()
 
 }
 
-bool X11Backend::init(weston_compositor *c)
+bool X11Backend::init(weston_compositor *c, const Config &)
 {
     weston_x11_backend_config config;
     config.base.struct_version = WESTON_X11_BACKEND_CONFIG_VERSION;
@@ -33,7 +33,7 @@ class X11Backend : public Backend
 public:
     X11Backend();
 
-    bool init(weston_compositor *c) override;
+    bool init(weston_compositor *c, const Config &config) override;
 
 private:
     Listener m_pendingListener;
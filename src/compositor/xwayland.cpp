@@ -26,9 +26,8 @@
 #include <errno.h>
 #include <unistd.h>
 #include <signal.h>
+#include <sys/wait.h>
 
-#include <QProcess>
-#include <QProcessEnvironment>
 #include <QDebug>
 
 #include "xwayland.h"
@@ -38,19 +37,11 @@
 #include "shellview.h"
 #include "seat.h"
 #include "surface.h"
+#include "process.h"
 #include "fmt/format.h"
 
 namespace Orbital {
 
-class XWayland::Process : public QProcess
-{
-public:
-    void setupChildProcess()
-    {
-        signal(SIGUSR1, SIG_IGN);
-    }
-};
-
 pid_t XWayland::spawnXserver(void *ud, const char *xdpy, int abstractFd, int unixFd)
 {
     XWayland *_this = static_cast<XWayland *>(ud);
@@ -67,38 +58,32 @@ pid_t XWayland::spawnXserver(void *ud, const char *xdpy, int abstractFd, int uni
         return 1;
     }
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    env.insert(QStringLiteral("WAYLAND_SOCKET"), QString::number(dup(sv[1])));
-
-    QString abstract_fd_str = QString::number(dup(abstractFd));
-    QString unix_fd_str = QString::number(dup(unixFd));
-    QString wm_fd_str = QString::number(dup(wm[1]));
+    wl_display *display = _this->m_shell->compositor()->display();
 
     delete _this->m_process;
-    _this->m_process = new Process;
-    _this->m_process->setProcessChannelMode(QProcess::ForwardedChannels);
-    _this->m_process->setProcessEnvironment(env);
-
-    _this->m_process->connect(_this->m_process, (void (QProcess::*)(int))&QProcess::finished, [_this](int exitCode) {
-        _this->m_api->xserver_exited(_this->m_xwayland, exitCode);
-        // The process should now be freed but QProcess doesn't like to be delete'd here directly,
-        // so we keep it alive and delete it when we quit or when we create a new process
+    Process *process = _this->m_process = new Process(wl_display_get_event_loop(display));
+    process->setProgram("Xwayland");
+    process->setEnvironment("WAYLAND_SOCKET", std::to_string(process->passFd(sv[1])));
+    process->setArguments({ xdpy,
+                            "-rootless",
+                            "-listen", std::to_string(process->passFd(abstractFd)),
+                            "-listen", std::to_string(process->passFd(unixFd)),
+                            "-wm", std::to_string(process->passFd(wm[1])),
+                            "-terminate" });
+    // Xwayland signals us with SIGUSR1 when it is ready, but only if it inherits it ignored
+    process->ignoreSignal(SIGUSR1);
+    process->setFinishedHandler([_this](int status) {
+        _this->m_api->xserver_exited(_this->m_xwayland, status);
     });
-    _this->m_process->start(QStringLiteral("Xwayland"), {
-                            QLatin1String(xdpy),
-                            QStringLiteral("-rootless"),
-                            QStringLiteral("-listen"), abstract_fd_str,
-                            QStringLiteral("-listen"), unix_fd_str,
-                            QStringLiteral("-wm"), wm_fd_str,
-                            QStringLiteral("-terminate") });
+    process->start();
 
     close(sv[1]);
-    _this->m_client = wl_client_create(_this->m_shell->compositor()->display(), sv[0]);
+    _this->m_client = wl_client_create(display, sv[0]);
 
     close(wm[1]);
     _this->m_wmFd = wm[0];
 
-    return _this->m_process->processId();
+    return process->pid();
 }
 
 class XWlSurface : public Interface {
@@ -165,11 +150,11 @@ XWayland::XWayland(Shell *shell)
 
 XWayland::~XWayland()
 {
-    if (m_process) {
-        m_process->kill();
-        m_process->waitForFinished();
-        delete m_process;
+    if (m_process && m_process->pid() > 0) {
+        kill(m_process->pid(), SIGKILL);
+        waitpid(m_process->pid(), nullptr, 0);
     }
+    delete m_process;
 }
 
 }
@@ -30,6 +30,7 @@ struct weston_xserver;
 namespace Orbital {
 
 class Shell;
+class Process;
 
 class XWayland : public Interface
 {
@@ -39,7 +40,6 @@ public:
 
 private:
     static pid_t spawnXserver(void *ud, const char *xdpy, int abstractFd, int unixFd);
-    class Process;
 
     Shell *m_shell;
     const weston_xwayland_api *m_api;
@@ -33,11 +33,13 @@
 #include <QTemporaryFile>
 #include <QProcess>
 #include <QClipboard>
+#include <QFile>
 #include <qpa/qplatformnativeinterface.h>
 
 #include <wayland-client.h>
 
 #include "../client/utils.h"
+#include "pngencoder.h"
 #include "wayland-screenshooter-client-protocol.h"
 #include "wayland-authorizer-client-protocol.h"
 
@@ -52,25 +54,12 @@ public:
     {
         int size = stride * height;
 
-        char filename[] = "/tmp/orbital-screenshooter-shm-XXXXXX";
-        int fd = mkstemp(filename);
+        int fd = createBufferFile(size);
         if (fd < 0) {
-            qWarning("creating a buffer file for %d B failed: %m\n", size);
-            return nullptr;
-        }
-        int flags = fcntl(fd, F_GETFD);
-        if (flags != -1 && fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1) {
-            qFatal("fcntl failed!");
-        }
-
-        if (ftruncate(fd, size) < 0) {
-            qWarning("ftruncate failed: %s", strerror(errno));
-            close(fd);
             return nullptr;
         }
 
         uchar *data = (uchar *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-        unlink(filename);
         if (data == (uchar *)MAP_FAILED) {
             qWarning("mmap failed: %m\n");
             close(fd);
@@ -92,6 +81,41 @@ public:
         return shot;
     }
 
+    // The shm pools are backed by sealed memfds, so that they never touch the disk and
+    // the compositor can trust their size. Fall back to an unlinked file in /tmp
+    // on kernels without memfd.
+    static int createBufferFile(int size)
+    {
+        int fd = memfd_create("orbital-screenshooter-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd >= 0) {
+            if (ftruncate(fd, size) < 0 || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+                qWarning("setting up a memfd of %d B failed: %m\n", size);
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        char filename[] = "/tmp/orbital-screenshooter-shm-XXXXXX";
+        fd = mkstemp(filename);
+        if (fd < 0) {
+            qWarning("creating a buffer file for %d B failed: %m\n", size);
+            return -1;
+        }
+        unlink(filename);
+        int flags = fcntl(fd, F_GETFD);
+        if (flags != -1 && fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1) {
+            qFatal("fcntl failed!");
+        }
+
+        if (ftruncate(fd, size) < 0) {
+            qWarning("ftruncate failed: %s", strerror(errno));
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
     Screenshooter *parent;
     QScreen *screen;
     wl_buffer *buffer;
@@ -326,6 +350,13 @@ public slots:
     {
         QString p = path;
         p.remove(0, 7); // Remove the "file://"
+        if (p.endsWith(QLatin1String(".png"), Qt::CaseInsensitive)) {
+            QFile file(p);
+            if (!file.open(QIODevice::WriteOnly) || !PngEncoder::write(m_imageProvider->m_image, &file)) {
+                qWarning("Cannot save the screenshot to %s", qPrintable(p));
+            }
+            return;
+        }
         if (!m_imageProvider->m_image.save(p)) {
             m_imageProvider->m_image.save(p + QLatin1String(".jpg"));
         }
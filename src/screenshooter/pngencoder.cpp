@@ -0,0 +1,167 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include <QImage>
+#include <QIODevice>
+#include <QtEndian>
+
+#include "pngencoder.h"
+
+static const int BandRows = 64;
+
+struct Band {
+    QByteArray data;
+    uLong adler;
+    uLong length;
+};
+
+static bool writeChunk(QIODevice *device, const char type[4], const char *data, uint32_t size)
+{
+    uchar header[8];
+    qToBigEndian<quint32>(size, header);
+    memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0, header + 4, 4);
+    if (size) {
+        crc = crc32(crc, reinterpret_cast<const Bytef *>(data), size);
+    }
+    uchar footer[4];
+    qToBigEndian<quint32>(crc, footer);
+
+    return device->write(reinterpret_cast<char *>(header), 8) == 8 &&
+           device->write(data, size) == size &&
+           device->write(reinterpret_cast<char *>(footer), 4) == 4;
+}
+
+// Filters the rows with the Up filter, which only looks at the row above and so
+// works across band boundaries, and deflates them. Only the last band closes the stream.
+static Band encodeBand(const QImage &image, int first, int last)
+{
+    const int width = image.width();
+    const uLong rowSize = width * 4 + 1;
+    std::vector<uchar> row(rowSize);
+    std::vector<uchar> prev(width * 4, 0);
+    std::vector<uchar> cur(width * 4);
+
+    if (first > 0) {
+        const QRgb *src = reinterpret_cast<const QRgb *>(image.constScanLine(first - 1));
+        for (int x = 0; x < width; ++x) {
+            uchar *p = &prev[x * 4];
+            p[0] = qRed(src[x]); p[1] = qGreen(src[x]); p[2] = qBlue(src[x]); p[3] = qAlpha(src[x]);
+        }
+    }
+
+    Band band;
+    band.adler = adler32(0, nullptr, 0);
+    band.length = 0;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    band.data.resize(deflateBound(&zs, rowSize * (last - first)) + 16);
+    zs.next_out = reinterpret_cast<Bytef *>(band.data.data());
+    zs.avail_out = band.data.size();
+
+    for (int y = first; y < last; ++y) {
+        const QRgb *src = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        row[0] = 2;
+        for (int x = 0; x < width; ++x) {
+            uchar *c = &cur[x * 4];
+            c[0] = qRed(src[x]); c[1] = qGreen(src[x]); c[2] = qBlue(src[x]); c[3] = qAlpha(src[x]);
+            for (int i = 0; i < 4; ++i) {
+                row[1 + x * 4 + i] = c[i] - prev[x * 4 + i];
+            }
+        }
+        std::swap(prev, cur);
+
+        band.adler = adler32(band.adler, row.data(), rowSize);
+        band.length += rowSize;
+        zs.next_in = row.data();
+        zs.avail_in = rowSize;
+        int flush = y + 1 < last ? Z_NO_FLUSH : (last == image.height() ? Z_FINISH : Z_SYNC_FLUSH);
+        deflate(&zs, flush);
+    }
+
+    band.data.resize(zs.total_out);
+    deflateEnd(&zs);
+    return band;
+}
+
+bool PngEncoder::write(const QImage &img, QIODevice *device)
+{
+    const QImage image = img.format() == QImage::Format_ARGB32 ? img : img.convertToFormat(QImage::Format_ARGB32);
+    if (image.isNull()) {
+        return false;
+    }
+
+    static const char signature[] = "\x89PNG\r\n\x1a\n";
+    if (device->write(signature, 8) != 8) {
+        return false;
+    }
+
+    uchar ihdr[13];
+    qToBigEndian<quint32>(image.width(), ihdr);
+    qToBigEndian<quint32>(image.height(), ihdr + 4);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 6; // RGBA
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    if (!writeChunk(device, "IHDR", reinterpret_cast<char *>(ihdr), 13)) {
+        return false;
+    }
+
+    // zlib header: deflate with a 32K window, default compression
+    static const char zlibHeader[] = "\x78\x9c";
+    if (!writeChunk(device, "IDAT", zlibHeader, 2)) {
+        return false;
+    }
+
+    // Keep at most one band per thread in flight, so that the memory used is bounded
+    // no matter how large the image is
+    const int threads = std::max(1u, std::thread::hardware_concurrency());
+    const int bands = (image.height() + BandRows - 1) / BandRows;
+    uLong adler = adler32(0, nullptr, 0);
+    for (int i = 0; i < bands; i += threads) {
+        std::vector<std::future<Band>> jobs;
+        for (int j = i; j < std::min(bands, i + threads); ++j) {
+            int first = j * BandRows;
+            int last = std::min(image.height(), first + BandRows);
+            jobs.push_back(std::async(std::launch::async, encodeBand, std::cref(image), first, last));
+        }
+        for (auto &job: jobs) {
+            Band band = job.get();
+            adler = adler32_combine(adler, band.adler, band.length);
+            if (!writeChunk(device, "IDAT", band.data.constData(), band.data.size())) {
+                return false;
+            }
+        }
+    }
+
+    uchar trailer[4];
+    qToBigEndian<quint32>(adler, trailer);
+    return writeChunk(device, "IDAT", reinterpret_cast<char *>(trailer), 4) &&
+           writeChunk(device, "IEND", nullptr, 0);
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2013-2014 Giulio Camuffo <giuliocamuffo@gmail.com>
+ *
+ * This file is part of Orbital
+ *
+ * Orbital is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Orbital is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Orbital.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PNGENCODER_H
+#define PNGENCODER_H
+
+class QImage;
+class QIODevice;
+
+/**
+ * Writes an ARGB32 image as a PNG, deflating bands of rows on worker threads.
+ * Every band is compressed on its own and flushed to a byte boundary, so the
+ * results can be concatenated in a single zlib stream and written out in order
+ * as soon as they are ready, without holding the whole encoded image.
+ */
+class PngEncoder
+{
+public:
+    static bool write(const QImage &image, QIODevice *device);
+};
+
+#endif
@@ -0,0 +1,91 @@
+// Compares how long the compositor is blocked when spawning a child with
+// QProcess and with Process, with a given amount of resident memory.
+// Usage: bench_process [iterations] [resident MiB] [program]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QProcess>
+
+#include <wayland-server.h>
+
+#include "process.h"
+#include "timer.h"
+
+using namespace Orbital;
+
+// The Process watch only needs a timer when there is no pidfd
+void Timer::singleShot(int msecs, const std::function<void ()> &func)
+{
+    fprintf(stderr, "pidfd_open is not available, the benchmark needs it\n");
+    exit(1);
+}
+
+static double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void report(const char *name, std::vector<double> &times)
+{
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (double t: times) {
+        sum += t;
+    }
+    printf("%-10s min %8.1f us  median %8.1f us  mean %8.1f us  max %8.1f us\n", name, times.front(),
+           times[times.size() / 2], sum / times.size(), times.back());
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    size_t resident = (argc > 2 ? atoi(argv[2]) : 256) * 1024 * 1024;
+    const char *program = argc > 3 ? argv[3] : "/bin/true";
+
+    // Stands in for the memory the compositor has mapped, that fork() has to copy the page tables of
+    char *memory = static_cast<char *>(malloc(resident));
+    memset(memory, 1, resident);
+
+    std::vector<double> qprocess, process;
+    QString qprogram = QString::fromLatin1(program);
+    wl_event_loop *loop = wl_event_loop_create();
+
+    for (int i = 0; i < iterations; ++i) {
+        QProcess *qp = new QProcess;
+        double start = now();
+        qp->start(qprogram, QStringList());
+        qprocess.push_back(now() - start);
+        qp->waitForFinished(-1);
+        delete qp;
+
+        Process p(loop);
+        bool finished = false;
+        p.setProgram(program);
+        p.setFinishedHandler([&](int) { finished = true; });
+        start = now();
+        p.start();
+        process.push_back(now() - start);
+        while (!finished) {
+            wl_event_loop_dispatch(loop, -1);
+        }
+    }
+
+    printf("%d spawns of %s, %zu MiB resident\n", iterations, program, resident / 1024 / 1024);
+    report("QProcess", qprocess);
+    report("Process", process);
+
+    wl_event_loop_destroy(loop);
+    free(memory);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <map>
+
+#include "fullscreenscene.h"
+
+using namespace Orbital;
+
+class TstFullscreenScene : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cover();
+    void twoViews();
+    void layers();
+    void reset();
+};
+
+// A fake output: the fullscreen layer and the layers below it, with their view counts
+struct Scene
+{
+    Scene()
+        : scene([this](int layer, bool linked) { this->linked[layer] = linked; })
+    {
+        for (const auto &l: views) {
+            linked[l.first] = true;
+            if (l.first != Fullscreen) {
+                scene.addLayer(l.first);
+            }
+        }
+    }
+
+    // the views weston walks when repainting a frame
+    int repainted() const
+    {
+        int n = 0;
+        for (const auto &l: views) {
+            if (linked.at(l.first)) {
+                n += l.second;
+            }
+        }
+        return n;
+    }
+
+    enum { Fullscreen, Panels, Sticky, Dashboard, Apps, BaseBackground };
+    std::map<int, int> views = { { Fullscreen, 1 }, { Panels, 2 }, { Sticky, 1 }, { Dashboard, 3 },
+                                 { Apps, 10 }, { BaseBackground, 1 } };
+    std::map<int, bool> linked;
+    FullscreenScene<int> scene;
+};
+
+void TstFullscreenScene::cover()
+{
+    Scene s;
+    QCOMPARE(s.repainted(), 18);
+
+    QVERIFY(s.scene.setFullscreen(&s, true));
+    QVERIFY(s.scene.isCovered());
+    QCOMPARE(s.repainted(), 1);
+
+    QVERIFY(!s.scene.setFullscreen(&s, true));
+    QCOMPARE(s.repainted(), 1);
+
+    QVERIFY(s.scene.setFullscreen(&s, false));
+    QVERIFY(!s.scene.isCovered());
+    QCOMPARE(s.repainted(), 18);
+}
+
+void TstFullscreenScene::twoViews()
+{
+    Scene s;
+    int first, second;
+
+    QVERIFY(s.scene.setFullscreen(&first, true));
+    QVERIFY(!s.scene.setFullscreen(&second, true));
+    QCOMPARE(s.repainted(), 1);
+
+    // the other workspace view is still fullscreen
+    QVERIFY(!s.scene.setFullscreen(&first, false));
+    QVERIFY(s.scene.isCovered());
+    QCOMPARE(s.repainted(), 1);
+
+    QVERIFY(!s.scene.setFullscreen(&first, false));
+    QVERIFY(s.scene.setFullscreen(&second, false));
+    QCOMPARE(s.repainted(), 18);
+}
+
+void TstFullscreenScene::layers()
+{
+    Scene s;
+    s.scene.setFullscreen(&s, true);
+
+    s.views[10] = 4;
+    s.linked[10] = true;
+    s.scene.addLayer(10);
+    QCOMPARE(s.repainted(), 1);
+
+    s.scene.removeLayer(Scene::Sticky);
+    QVERIFY(s.linked[Scene::Sticky]);
+    QCOMPARE(s.repainted(), 2);
+
+    s.scene.setFullscreen(&s, false);
+    QCOMPARE(s.repainted(), 22);
+}
+
+void TstFullscreenScene::reset()
+{
+    Scene s;
+    int first, second;
+    s.scene.setFullscreen(&first, true);
+    s.scene.setFullscreen(&second, true);
+
+    s.scene.reset();
+    QVERIFY(!s.scene.isCovered());
+    QCOMPARE(s.repainted(), 18);
+
+    QVERIFY(s.scene.setFullscreen(&first, true));
+    QCOMPARE(s.repainted(), 1);
+}
+
+QTEST_MAIN(TstFullscreenScene)
+#include "tst_fullscreenscene.moc"
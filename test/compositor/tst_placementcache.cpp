@@ -0,0 +1,110 @@
+#include <QObject>
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
+#include "placementcache.h"
+
+using namespace Orbital;
+
+class TstPlacementCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void storeAndFind();
+    void persistence();
+    void eviction();
+    void capacityChange();
+    void reopenAfterEviction();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+static PlacementCache::Placement placement(int x, int y)
+{
+    return { QPoint(x, y), QSize(640, 480), "DP-1", 2 };
+}
+
+void TstPlacementCache::storeAndFind()
+{
+    PlacementCache cache(m_dir.path() + QLatin1String("/storeAndFind"));
+    QVERIFY(!cache.find("app"));
+
+    cache.store("app", placement(10, 20));
+    cache.store("other", placement(30, 40));
+    cache.store("app", placement(50, 60));
+
+    Maybe<PlacementCache::Placement> p = cache.find("app");
+    QVERIFY(p);
+    QCOMPARE(p.value().pos, QPoint(50, 60));
+    QCOMPARE(p.value().size, QSize(640, 480));
+    QCOMPARE(p.value().output, std::string("DP-1"));
+    QCOMPARE(p.value().workspace, 2);
+    QCOMPARE(cache.find("other").value().pos, QPoint(30, 40));
+}
+
+void TstPlacementCache::persistence()
+{
+    QString path = m_dir.path() + QLatin1String("/persistence");
+    {
+        PlacementCache cache(path);
+        cache.store("app", placement(10, 20));
+    }
+
+    PlacementCache cache(path);
+    QVERIFY(cache.find("app"));
+    QCOMPARE(cache.find("app").value().pos, QPoint(10, 20));
+}
+
+void TstPlacementCache::eviction()
+{
+    PlacementCache cache(m_dir.path() + QLatin1String("/eviction"), 2);
+    cache.store("a", placement(1, 1));
+    cache.store("b", placement(2, 2));
+    // using "a" makes "b" the least recently used
+    QVERIFY(cache.find("a"));
+    cache.store("c", placement(3, 3));
+
+    QVERIFY(cache.find("a"));
+    QVERIFY(!cache.find("b"));
+    QVERIFY(cache.find("c"));
+}
+
+void TstPlacementCache::capacityChange()
+{
+    QString path = m_dir.path() + QLatin1String("/capacity");
+    {
+        PlacementCache cache(path, 4);
+        cache.store("app", placement(10, 20));
+    }
+
+    PlacementCache cache(path, 8);
+    QVERIFY(!cache.find("app"));
+    cache.store("app", placement(10, 20));
+    QVERIFY(cache.find("app"));
+}
+
+void TstPlacementCache::reopenAfterEviction()
+{
+    QString path = m_dir.path() + QLatin1String("/reopen");
+    {
+        PlacementCache cache(path, 2);
+        cache.store("a", placement(1, 1));
+        cache.store("b", placement(2, 2));
+        cache.store("c", placement(3, 3));
+        QVERIFY(!cache.find("a"));
+    }
+
+    PlacementCache cache(path, 2);
+    QVERIFY(!cache.find("a"));
+    QCOMPARE(cache.find("b").value().pos, QPoint(2, 2));
+    QCOMPARE(cache.find("c").value().pos, QPoint(3, 3));
+    // "b" is the least recently used again
+    QVERIFY(cache.find("c"));
+    cache.store("a", placement(4, 4));
+    QVERIFY(!cache.find("b"));
+    QCOMPARE(cache.find("a").value().pos, QPoint(4, 4));
+}
+
+QTEST_MAIN(TstPlacementCache)
+#include "tst_placementcache.moc"
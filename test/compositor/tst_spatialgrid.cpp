@@ -0,0 +1,68 @@
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "spatialgrid.h"
+
+using namespace Orbital;
+
+class TstSpatialGrid : public QObject
+{
+    Q_OBJECT
+private slots:
+    void order();
+    void move();
+    void outside();
+};
+
+static std::vector<int> values(const std::vector<SpatialGrid<int>::Entry> &cell)
+{
+    std::vector<int> v;
+    for (const auto &e: cell) {
+        v.push_back(e.value);
+    }
+    return v;
+}
+
+void TstSpatialGrid::order()
+{
+    SpatialGrid<int> grid(100);
+    grid.reset(QRect(0, 0, 1000, 500));
+
+    grid.insert(1, 0, QRect(0, 0, 1000, 500));
+    grid.insert(3, 2, QRect(50, 50, 100, 100));
+    grid.insert(2, 1, QRect(120, 120, 10, 10));
+
+    QCOMPARE(values(grid.at(125, 125)), std::vector<int>({ 1, 2, 3 }));
+    QCOMPARE(values(grid.at(10, 10)), std::vector<int>({ 1, 3 }));
+    QCOMPARE(values(grid.at(999, 499)), std::vector<int>({ 1 }));
+}
+
+void TstSpatialGrid::move()
+{
+    SpatialGrid<int> grid(100);
+    grid.reset(QRect(-500, 0, 1000, 500));
+
+    QRect box(-500, 0, 50, 50);
+    grid.insert(1, 0, box);
+    QCOMPARE(values(grid.at(-480, 20)), std::vector<int>({ 1 }));
+
+    grid.remove(1, box);
+    box.moveTo(300, 300);
+    grid.insert(1, 0, box);
+    QVERIFY(grid.at(-480, 20).empty());
+    QCOMPARE(values(grid.at(310, 310)), std::vector<int>({ 1 }));
+}
+
+void TstSpatialGrid::outside()
+{
+    SpatialGrid<int> grid(100);
+    grid.reset(QRect(0, 0, 200, 200));
+
+    grid.insert(1, 0, QRect(-1000, -1000, 5000, 5000));
+    QVERIFY(grid.at(-10, 10).empty());
+    QVERIFY(grid.at(200, 10).empty());
+    QCOMPARE(values(grid.at(199, 199)), std::vector<int>({ 1 }));
+}
+
+QTEST_MAIN(TstSpatialGrid)
+#include "tst_spatialgrid.moc"
@@ -0,0 +1,125 @@
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <vector>
+#include <set>
+
+#include "timerwheel.h"
+
+using namespace Orbital;
+
+class TstTimerWheel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void expire();
+    void zeroDelay();
+    void cascade();
+    void remove();
+    void slack();
+};
+
+static std::vector<uint64_t> expireAll(TimerWheel &wheel, uint64_t now)
+{
+    std::vector<uint64_t> expired;
+    while (TimerWheel::Node *n = wheel.takeExpired(now)) {
+        expired.push_back(n->expires);
+    }
+    return expired;
+}
+
+void TstTimerWheel::expire()
+{
+    TimerWheel wheel(1000);
+    TimerWheel::Node a, b, c;
+    wheel.add(&a, 1010);
+    wheel.add(&b, 1005);
+    wheel.add(&c, 990);
+
+    QCOMPARE(wheel.nextExpiry(), uint64_t(1000));
+    QCOMPARE(expireAll(wheel, 1000), std::vector<uint64_t>({ 990 }));
+    QCOMPARE(wheel.nextExpiry(), uint64_t(1005));
+    QCOMPARE(expireAll(wheel, 1009), std::vector<uint64_t>({ 1005 }));
+    QVERIFY(a.isPending());
+    QCOMPARE(expireAll(wheel, 2000), std::vector<uint64_t>({ 1010 }));
+    QVERIFY(!a.isPending());
+    QVERIFY(wheel.isEmpty());
+    QCOMPARE(wheel.nextExpiry(), TimerWheel::NoExpiry);
+}
+
+void TstTimerWheel::zeroDelay()
+{
+    TimerWheel wheel(1000);
+    TimerWheel::Node a, b, c;
+    wheel.add(&a, 1005);
+    QCOMPARE(expireAll(wheel, 1005), std::vector<uint64_t>({ 1005 }));
+
+    // added when its tick was already processed, like a timer re-armed by its callback
+    wheel.add(&b, 1005);
+    wheel.add(&c, 1006);
+    QCOMPARE(wheel.nextExpiry(), uint64_t(1005));
+    QCOMPARE(expireAll(wheel, 1005), std::vector<uint64_t>({ 1005 }));
+    QCOMPARE(wheel.nextExpiry(), uint64_t(1006));
+
+    // re-armed again and again, it doesn't drift
+    for (uint64_t t = 1006; t < 1010; ++t) {
+        QCOMPARE(expireAll(wheel, t), std::vector<uint64_t>({ t }));
+        wheel.add(&c, t + 1);
+        QCOMPARE(wheel.nextExpiry(), t + 1);
+    }
+    wheel.remove(&c);
+    QVERIFY(wheel.isEmpty());
+}
+
+void TstTimerWheel::cascade()
+{
+    TimerWheel wheel(0);
+    std::vector<TimerWheel::Node> nodes(4);
+    const uint64_t times[] = { 300, 70000, 20000000, 5000000000ull };
+    for (int i = 0; i < 4; ++i) {
+        wheel.add(&nodes[i], times[i]);
+    }
+
+    for (uint64_t t: times) {
+        QCOMPARE(wheel.nextExpiry(), t);
+        QVERIFY(expireAll(wheel, t - 1).empty());
+        QCOMPARE(expireAll(wheel, t), std::vector<uint64_t>({ t }));
+    }
+    QVERIFY(wheel.isEmpty());
+}
+
+void TstTimerWheel::remove()
+{
+    TimerWheel wheel(0);
+    TimerWheel::Node a, b;
+    wheel.add(&a, 10);
+    wheel.add(&b, 100000);
+    wheel.remove(&b);
+    QCOMPARE(wheel.nextExpiry(), uint64_t(10));
+
+    // re-adding moves the timer
+    wheel.add(&a, 50);
+    QVERIFY(expireAll(wheel, 20).empty());
+    QCOMPARE(expireAll(wheel, 200000), std::vector<uint64_t>({ 50 }));
+}
+
+void TstTimerWheel::slack()
+{
+    QCOMPARE(TimerWheel::applySlack(1000, 0), uint64_t(1000));
+    QCOMPARE(TimerWheel::applySlack(1001, 100), uint64_t(1024));
+    QCOMPARE(TimerWheel::applySlack(1020, 100), uint64_t(1024));
+
+    // nearby deadlines are merged
+    std::set<uint64_t> expiries;
+    for (uint64_t t = 10001; t < 10050; ++t) {
+        expiries.insert(TimerWheel::applySlack(t, 100));
+    }
+    QVERIFY(expiries.size() <= 2);
+    for (uint64_t t = 0; t < 5000; t += 7) {
+        uint64_t e = TimerWheel::applySlack(t, 250);
+        QVERIFY(e >= t && e <= t + 250);
+    }
+}
+
+QTEST_MAIN(TstTimerWheel)
+#include "tst_timerwheel.moc"
@@ -0,0 +1,152 @@
+#include <string.h>
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include <wayland-server.h>
+
+#include "transform.h"
+
+using namespace Orbital;
+
+// What Transform used to be: a whole weston_transform, whose copies relink the
+// list node and whose interpolation blends the whole matrix
+struct MatrixTransform {
+    MatrixTransform()
+        : type(0)
+    {
+        wl_list_init(&link);
+        for (int i = 0; i < 16; ++i) {
+            d[i] = i % 5 == 0 ? 1 : 0;
+        }
+    }
+    MatrixTransform(const MatrixTransform &t) : MatrixTransform() { *this = t; }
+    MatrixTransform &operator=(const MatrixTransform &t)
+    {
+        wl_list_remove(&link);
+        wl_list_init(&link);
+        memcpy(d, t.d, sizeof(d));
+        type = t.type;
+        if (list) {
+            wl_list_insert(list, &link);
+        }
+        return *this;
+    }
+
+    float d[16];
+    unsigned int type;
+    wl_list link;
+    wl_list *list = nullptr;
+};
+
+static const int NumWorkspaces = 9;
+// 300ms at 60Hz, like the pager animation
+static const int NumFrames = 18;
+
+class TstTransform : public QObject
+{
+    Q_OBJECT
+private slots:
+    void compose();
+    void type();
+    void interpolate();
+    void matrixSwitchBenchmark();
+    void switchBenchmark();
+};
+
+void TstTransform::compose()
+{
+    Transform t;
+    t.translate(10, 20);
+    t.scale(2, 0.5);
+    QCOMPARE(t.map(QPointF(1, 2)), QPointF(22, 11));
+
+    t.reset();
+    t.scale(2, 2);
+    t.translate(-5, 5);
+    QCOMPARE(t.map(QPointF(1, 2)), QPointF(-3, 9));
+}
+
+void TstTransform::type()
+{
+    Transform t;
+    QCOMPARE(t.type(), Transform::Type::Identity);
+    t.translate(-1920, 0);
+    QCOMPARE(t.type(), Transform::Type::Translate);
+    t.scale(0.5, 0.5);
+    QCOMPARE(t.type(), Transform::Type::Scale);
+    t.scale(2, 2);
+    t.translate(1920, 0);
+    QVERIFY(t.isIdentity());
+}
+
+void TstTransform::interpolate()
+{
+    Transform t1, t2;
+    t1.translate(-1920, 0);
+    t2.scale(0.25, 0.25);
+    t2.translate(100, 40);
+
+    QCOMPARE(Transform::interpolate(t1, t2, 0), t1);
+    QCOMPARE(Transform::interpolate(t1, t2, 1), t2);
+
+    Transform t = Transform::interpolate(t1, t2, 0.5);
+    QCOMPARE(t.type(), Transform::Type::Scale);
+    QCOMPARE(t.map(QPointF(0, 0)), QPointF(-910, 20));
+    QCOMPARE(t.map(QPointF(100, 100)), QPointF(-847.5, 82.5));
+
+    Transform t3;
+    t3.translate(-1920, 0);
+    QCOMPARE(Transform::interpolate(t1, t3, 0.3).type(), Transform::Type::Translate);
+}
+
+// Switching between workspaces animates the transform of each workspace view, and
+// sets it on the workspace root view on every frame
+void TstTransform::matrixSwitchBenchmark()
+{
+    std::vector<wl_list> lists(NumWorkspaces);
+    std::vector<MatrixTransform> orig(NumWorkspaces), target(NumWorkspaces), current(NumWorkspaces);
+    for (int i = 0; i < NumWorkspaces; ++i) {
+        wl_list_init(&lists[i]);
+        current[i].list = &lists[i];
+        target[i].d[12] = -1920 * (i % 3);
+        target[i].d[13] = -1080 * (i / 3);
+        target[i].type = 1;
+    }
+
+    QBENCHMARK {
+        for (int f = 1; f <= NumFrames; ++f) {
+            double v = (double)f / NumFrames;
+            for (int i = 0; i < NumWorkspaces; ++i) {
+                MatrixTransform t;
+                for (int j = 0; j < 16; ++j) {
+                    t.d[j] = orig[i].d[j] * (1. - v) + target[i].d[j] * v;
+                }
+                t.type = orig[i].type | target[i].type;
+                current[i] = t;
+            }
+        }
+    }
+    QCOMPARE(current[4].d[12], -1920.f);
+}
+
+void TstTransform::switchBenchmark()
+{
+    std::vector<Transform> orig(NumWorkspaces), target(NumWorkspaces), current(NumWorkspaces);
+    for (int i = 0; i < NumWorkspaces; ++i) {
+        target[i].translate(-1920 * (i % 3), -1080 * (i / 3));
+    }
+
+    QBENCHMARK {
+        for (int f = 1; f <= NumFrames; ++f) {
+            double v = (double)f / NumFrames;
+            for (int i = 0; i < NumWorkspaces; ++i) {
+                current[i] = Transform::interpolate(orig[i], target[i], v);
+            }
+        }
+    }
+    QCOMPARE(current[4].translateX(), -1920.);
+}
+
+QTEST_MAIN(TstTransform)
+#include "tst_transform.moc"
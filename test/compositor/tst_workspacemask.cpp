@@ -0,0 +1,75 @@
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "workspacemask.h"
+
+using namespace Orbital;
+
+class TstWorkspaceMask : public QObject
+{
+    Q_OBJECT
+private slots:
+    void contains();
+    void intersects();
+    void all();
+    void equality();
+};
+
+void TstWorkspaceMask::contains()
+{
+    WorkspaceMask mask(3);
+    mask.add(200);
+
+    QVERIFY(mask.contains(3));
+    QVERIFY(mask.contains(200));
+    QVERIFY(!mask.contains(4));
+    QVERIFY(!mask.contains(136));
+    QVERIFY(!mask.contains(1000));
+    QVERIFY(!mask.isEmpty());
+    QVERIFY(WorkspaceMask().isEmpty());
+}
+
+void TstWorkspaceMask::intersects()
+{
+    WorkspaceMask a(70);
+    WorkspaceMask b(134);
+    QVERIFY(!a.intersects(b));
+
+    WorkspaceMask outputs;
+    outputs |= a;
+    outputs |= WorkspaceMask(1);
+    QVERIFY(outputs.intersects(a));
+    QVERIFY(!outputs.intersects(b));
+    QVERIFY(outputs.contains(1));
+
+    b.add(70);
+    QVERIFY(outputs.intersects(b));
+}
+
+void TstWorkspaceMask::all()
+{
+    WorkspaceMask all = WorkspaceMask::all();
+    QVERIFY(all.contains(500));
+    QVERIFY(all.intersects(WorkspaceMask(500)));
+    QVERIFY(WorkspaceMask(2).intersects(all));
+    QVERIFY(!all.intersects(WorkspaceMask()));
+    QVERIFY(!all.isEmpty());
+}
+
+void TstWorkspaceMask::equality()
+{
+    WorkspaceMask a(5);
+    WorkspaceMask b(5);
+    b.add(300);
+    QVERIFY(a != b);
+
+    // The same set built in a different way
+    WorkspaceMask c(5);
+    c |= WorkspaceMask(300);
+    QVERIFY(b == c);
+    QVERIFY(a == WorkspaceMask(5));
+    QVERIFY(WorkspaceMask::all() != WorkspaceMask(5));
+}
+
+QTEST_MAIN(TstWorkspaceMask)
+#include "tst_workspacemask.moc"
@@ -0,0 +1,109 @@
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "utils.h"
+
+using namespace Orbital;
+
+// Mimics what weston and Orbital attach to the destroy signal of a view
+struct FakeView {
+    wl_signal destroy_signal;
+    wl_listener listeners[4];
+};
+
+struct Wrapper {
+    wl_listener listener;
+    FakeView *view;
+};
+
+static void wrapperDestroyed(wl_listener *, void *) {}
+static void otherDestroyed(wl_listener *, void *) {}
+
+static const int NumViews = 500;
+
+class TstWrapperMap : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void lookup();
+    void signalGetBenchmark();
+    void wrapperMapBenchmark();
+
+private:
+    std::vector<FakeView *> m_views;
+    std::vector<Wrapper *> m_wrappers;
+    WrapperMap<FakeView, Wrapper> m_map;
+};
+
+void TstWrapperMap::initTestCase()
+{
+    for (int i = 0; i < NumViews; ++i) {
+        FakeView *v = new FakeView;
+        wl_signal_init(&v->destroy_signal);
+        // the wrapper's listener is added after the others, as it happens for
+        // views whose wrapper is created lazily
+        for (wl_listener &l: v->listeners) {
+            l.notify = otherDestroyed;
+            wl_signal_add(&v->destroy_signal, &l);
+        }
+
+        Wrapper *w = new Wrapper;
+        w->view = v;
+        w->listener.notify = wrapperDestroyed;
+        wl_signal_add(&v->destroy_signal, &w->listener);
+
+        m_views.push_back(v);
+        m_wrappers.push_back(w);
+        m_map.insert(v, w);
+    }
+}
+
+void TstWrapperMap::cleanupTestCase()
+{
+    qDeleteAll(m_wrappers);
+    qDeleteAll(m_views);
+}
+
+void TstWrapperMap::lookup()
+{
+    QCOMPARE(m_map.size(), (size_t)NumViews);
+    for (int i = 0; i < NumViews; ++i) {
+        QCOMPARE(m_map.find(m_views[i]), m_wrappers[i]);
+    }
+
+    FakeView other;
+    QVERIFY(!m_map.find(&other));
+
+    m_map.remove(m_views[0]);
+    QVERIFY(!m_map.find(m_views[0]));
+    m_map.insert(m_views[0], m_wrappers[0]);
+    QCOMPARE(m_map.find(m_views[0]), m_wrappers[0]);
+}
+
+void TstWrapperMap::signalGetBenchmark()
+{
+    Wrapper *w = nullptr;
+    QBENCHMARK {
+        for (FakeView *v: m_views) {
+            wl_listener *l = wl_signal_get(&v->destroy_signal, wrapperDestroyed);
+            w = wl_container_of(l, w, listener);
+        }
+    }
+    QCOMPARE(w, m_wrappers.back());
+}
+
+void TstWrapperMap::wrapperMapBenchmark()
+{
+    Wrapper *w = nullptr;
+    QBENCHMARK {
+        for (FakeView *v: m_views) {
+            w = m_map.find(v);
+        }
+    }
+    QCOMPARE(w, m_wrappers.back());
+}
+
+QTEST_MAIN(TstWrapperMap)
+#include "tst_wrappermap.moc"